@@ -0,0 +1,580 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "../src/core/vll_stman.h"
+#include "../src/concurrency/vll.h"
+#include "../src/concurrency/sca.h"
+#include "../src/concurrency/lock_manager_2pl.h"
+#include "../src/transaction/transaction.h"
+
+// Isolated microbenchmarks of the components the end-to-end benchmark
+// hides behind its simulated work: storage lookups, SCA, TxnQueue
+// admission/finish and 2PL acquisition. Each case is timed over repeated
+// samples and reported as ns/op with a 95% confidence interval; --csv and
+// --baseline turn a run into a regression gate. --footprint instead reports
+// store memory per key and overwrite throughput as the store grows.
+struct ComponentConfig {
+    std::vector<std::string> benches;       // empty runs every case
+    std::vector<int> keys = {100000};       // records in the store / lock key space
+    std::vector<int> set_sizes = {10};      // keys per transaction, all written
+    std::vector<int> queue_depths = {64};   // transactions already in the queue
+    std::vector<int> threads = {1};
+    std::vector<int> value_sizes = {16};    // bytes per stored value
+    bool footprint = false;
+    int samples = 20;
+    int sample_ms = 20;                     // target length of one sample
+    std::string csv_path;
+    std::string baseline_path;
+    double max_regression_pct = 10.0;     // run-to-run drift exceeds the CI on noisy hosts
+};
+
+struct Params {
+    int keys;
+    int set_size;
+    int queue_depth;
+    int threads;
+    int value_size;
+};
+
+// Performs n operations as thread tid of a case. Cases set up all state
+// before the first call, so the timed loop does no allocation of its own.
+using CaseRun = std::function<void(int tid, uint64_t n)>;
+
+struct CaseDef {
+    const char* name;
+    const char* description;
+    bool usesKeys, usesSetSize, usesQueueDepth, usesThreads, usesValueSize;
+    std::function<CaseRun(const Params&)> setup;
+};
+
+static std::atomic<uint64_t> g_sink{0};
+
+static std::string key_name(int64_t idx) { return "k" + std::to_string(idx); }
+
+static void preload(storageManager& store, int64_t keys, int value_size = 1) {
+    std::string value(static_cast<std::size_t>(std::max(0, value_size)), 'v');
+    for (int64_t i = 0; i < keys; ++i) {
+        std::string k = key_name(i);
+        store.insert(k, value);
+    }
+}
+
+// Sorted, distinct random keys from [0, keys).
+template <class URNG>
+static std::vector<std::string> random_set(URNG& rng, int keys, int n) {
+    std::uniform_int_distribution<int64_t> dist(0, std::max(1, keys) - 1);
+    std::vector<std::string> out;
+    while (static_cast<int>(out.size()) < std::min(n, keys)) {
+        std::string k = key_name(dist(rng));
+        if (std::find(out.begin(), out.end(), k) == out.end()) out.push_back(std::move(k));
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static CaseRun storage_get(const Params& p, bool rehash) {
+    auto store = std::make_shared<storageManager>();
+    preload(*store, p.keys);
+    constexpr std::size_t kProbe = 1 << 16;
+    auto names = std::make_shared<std::vector<std::string>>();
+    auto handles = std::make_shared<std::vector<KeyHandle>>();
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<int64_t> dist(0, p.keys - 1);
+    for (std::size_t i = 0; i < kProbe; ++i) names->push_back(key_name(dist(rng)));
+    for (const auto& n : *names) handles->emplace_back(n);
+    return [store, names, handles, rehash](int tid, uint64_t n) {
+        uint64_t sum = 0;
+        std::size_t at = static_cast<std::size_t>(tid) * 7919;
+        for (uint64_t i = 0; i < n; ++i, ++at) {
+            tuple* t = rehash ? store->get(std::string_view((*names)[at % kProbe]))
+                              : store->get((*handles)[at % kProbe]);
+            sum += reinterpret_cast<uintptr_t>(t);
+        }
+        g_sink.fetch_add(sum, std::memory_order_relaxed);
+    };
+}
+
+// Same-size overwrites, which stay in place. Thread tid only writes keys
+// i with i % threads == tid, as exclusive locks would ensure.
+static CaseRun storage_overwrite(const Params& p) {
+    auto store = std::make_shared<storageManager>();
+    const int64_t keys = std::max(p.keys, p.threads);
+    preload(*store, keys, p.value_size);
+    constexpr std::size_t kProbe = 1 << 16;
+    auto targets = std::make_shared<std::vector<std::vector<tuple*>>>(p.threads);
+    std::mt19937_64 rng(17);
+    std::uniform_int_distribution<int64_t> dist(0, keys / p.threads - 1);
+    for (int t = 0; t < p.threads; ++t) {
+        for (std::size_t i = 0; i < kProbe; ++i) {
+            std::string k = key_name(dist(rng) * p.threads + t);
+            (*targets)[t].push_back(store->get(k));
+        }
+    }
+    auto values = std::make_shared<std::vector<std::string>>();
+    for (char c : {'a', 'b'}) values->push_back(std::string(static_cast<std::size_t>(p.value_size), c));
+    return [store, targets, values](int tid, uint64_t n) {
+        const auto& ts = (*targets)[tid];
+        for (uint64_t i = 0; i < n; ++i) store->write(ts[i % kProbe], (*values)[i & 1], i);
+    };
+}
+
+// The oldest transaction writes a key every other one also writes, so no
+// blocked transaction is runnable and each call scans the whole queue.
+static CaseRun sca_analyze(const Params& p) {
+    auto queue = std::make_shared<std::deque<ConcVLL::txn_ptr>>();
+    std::mt19937_64 rng(11);
+    for (int i = 0; i < p.queue_depth; ++i) {
+        auto keys = random_set(rng, p.keys, std::max(1, p.set_size - 1));
+        keys.push_back("hot");
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        auto T = std::make_shared<ConcVLL::Transaction>(static_cast<uint64_t>(i + 1));
+        T->assignKeys({}, keys);
+        T->type = i == 0 ? ConcVLL::Transaction::Type::Free : ConcVLL::Transaction::Type::Blocked;
+        queue->push_back(std::move(T));
+    }
+    return [queue](int, uint64_t n) {
+        uint64_t found = 0;
+        for (uint64_t i = 0; i < n; ++i) found += ConcVLL::SCA::analyze(*queue) != nullptr;
+        g_sink.fetch_add(found, std::memory_order_relaxed);
+    };
+}
+
+// Uncontended admit + finish: each thread reuses one transaction over its
+// own keys, behind queue_depth transactions that never finish.
+static CaseRun queue_begin_finish(const Params& p) {
+    auto store = std::make_shared<storageManager>();
+    auto queue = std::make_shared<ConcVLL::TxnQueue>();
+    preload(*store, p.keys);
+    std::vector<std::string> parked;
+    for (int i = 0; i < p.queue_depth; ++i) parked.push_back("parked" + std::to_string(i));
+    for (const auto& k : parked) store->insert(k, std::string());
+    for (const auto& k : parked) {
+        auto T = std::make_shared<ConcVLL::Transaction>();
+        T->assignKeys({}, {k});
+        queue->BeginTransaction(T, *store);
+    }
+
+    auto txns = std::make_shared<std::vector<ConcVLL::txn_ptr>>();
+    for (int t = 0; t < p.threads; ++t) {
+        std::vector<std::string> keys;
+        for (int i = 0; i < p.set_size; ++i) keys.push_back("t" + std::to_string(t) + "_" + std::to_string(i));
+        std::sort(keys.begin(), keys.end());
+        // Created now: the store must not grow while threads look keys up.
+        for (const auto& k : keys) store->insert(k, std::string());
+        auto T = std::make_shared<ConcVLL::Transaction>();
+        T->assignKeys({}, keys);
+        txns->push_back(std::move(T));
+    }
+    return [store, queue, txns](int tid, uint64_t n) {
+        const auto& T = (*txns)[tid];
+        for (uint64_t i = 0; i < n; ++i) {
+            T->id = 0;
+            queue->BeginTransaction(T, *store);
+            queue->FinishTransaction(T, *store);
+        }
+    };
+}
+
+static CaseRun lock_acquire_release(const Params& p) {
+    auto lm = std::make_shared<LockManager2PL>();
+    constexpr std::size_t kSets = 256;
+    auto names = std::make_shared<std::vector<std::vector<std::string>>>();
+    auto sets = std::make_shared<std::vector<std::vector<KeyHandle>>>();
+    std::mt19937_64 rng(13);
+    for (std::size_t i = 0; i < kSets * p.threads; ++i) names->push_back(random_set(rng, p.keys, p.set_size));
+    for (const auto& s : *names) sets->emplace_back(s.begin(), s.end());
+    return [lm, names, sets](int tid, uint64_t n) {
+        static const std::vector<KeyHandle> none;
+        for (uint64_t i = 0; i < n; ++i) {
+            const auto& writes = (*sets)[tid * kSets + i % kSets];
+            lm->acquire_all_atomically(none, writes);
+            lm->release_all(none, writes);
+        }
+    };
+}
+
+static const std::vector<CaseDef>& cases() {
+    static const std::vector<CaseDef> all = {
+        {"storage.get", "storageManager::get by precomputed KeyHandle", true, false, false, true, false,
+         [](const Params& p) { return storage_get(p, false); }},
+        {"storage.get_rehash", "storageManager::get hashing the key on every call", true, false, false, true, false,
+         [](const Params& p) { return storage_get(p, true); }},
+        {"storage.overwrite", "storageManager::write of a same-size value", true, false, false, true, true,
+         storage_overwrite},
+        {"sca.analyze", "SCA::analyze over a queue with no runnable transaction", true, true, true, false, false,
+         sca_analyze},
+        {"queue.begin_finish", "TxnQueue::BeginTransaction + FinishTransaction, uncontended", true, true, true, true,
+         false, queue_begin_finish},
+        {"2pl.acquire_release", "LockManager2PL::acquire_all_atomically + release_all", true, true, false, true,
+         false, lock_acquire_release},
+    };
+    return all;
+}
+
+// Wall time for every thread to run n operations, started together.
+static double time_batch(const CaseRun& run, int threads, uint64_t n) {
+    using clock = std::chrono::steady_clock;
+    if (threads == 1) {
+        auto t0 = clock::now();
+        run(0, n);
+        return std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+    }
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<clock::time_point> done(threads);
+    std::vector<std::thread> ts;
+    for (int t = 0; t < threads; ++t) {
+        ts.emplace_back([&, t] {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            run(t, n);
+            done[t] = clock::now();
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    auto t0 = clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : ts) t.join();
+    return std::chrono::duration<double, std::nano>(*std::max_element(done.begin(), done.end()) - t0).count();
+}
+
+struct Summary {
+    double mean = 0, ci95 = 0, median = 0, min = 0;
+    int samples = 0;
+};
+
+// Two-sided 95% Student t quantiles for 1..30 degrees of freedom.
+static double t95(int df) {
+    static const double t[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                               2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                               2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df < 1) return 0;
+    return df <= 30 ? t[df - 1] : 1.96;
+}
+
+static Summary summarize(std::vector<double> v) {
+    Summary s;
+    s.samples = static_cast<int>(v.size());
+    if (v.empty()) return s;
+    std::sort(v.begin(), v.end());
+    s.min = v.front();
+    s.median = v.size() % 2 ? v[v.size() / 2] : (v[v.size() / 2 - 1] + v[v.size() / 2]) / 2;
+    for (double x : v) s.mean += x;
+    s.mean /= double(v.size());
+    if (v.size() > 1) {
+        double var = 0;
+        for (double x : v) var += (x - s.mean) * (x - s.mean);
+        var /= double(v.size() - 1);
+        s.ci95 = t95(s.samples - 1) * std::sqrt(var / double(v.size()));
+    }
+    return s;
+}
+
+// Grows the batch until one takes about sample_ms, then times `samples`
+// batches. Each sample is ns per operation per thread.
+static Summary measure(const CaseRun& run, int threads, const ComponentConfig& cfg) {
+    const double target = double(cfg.sample_ms) * 1e6;
+    uint64_t n = 1;
+    double ns = time_batch(run, threads, n);
+    while (ns < target / 4 && n < (uint64_t(1) << 40)) {
+        n *= 2;
+        ns = time_batch(run, threads, n);
+    }
+    n = std::max<uint64_t>(1, static_cast<uint64_t>(double(n) * target / std::max(ns, 1.0)));
+
+    std::vector<double> per_op;
+    for (int i = 0; i < cfg.samples; ++i) per_op.push_back(time_batch(run, threads, n) / double(n));
+    return summarize(per_op);
+}
+
+static std::string params_label(const CaseDef& c, const Params& p) {
+    std::ostringstream os;
+    if (c.usesKeys) os << " keys=" << p.keys;
+    if (c.usesSetSize) os << " set_size=" << p.set_size;
+    if (c.usesQueueDepth) os << " queue_depth=" << p.queue_depth;
+    if (c.usesThreads) os << " threads=" << p.threads;
+    if (c.usesValueSize) os << " value_size=" << p.value_size;
+    return os.str();
+}
+
+static std::string result_key(const std::string& name, const Params& p) {
+    std::ostringstream os;
+    os << name << ',' << p.keys << ',' << p.set_size << ',' << p.queue_depth << ',' << p.threads << ','
+       << p.value_size;
+    return os.str();
+}
+
+// mean and ci95 by result_key, from a CSV written by --csv.
+static std::map<std::string, std::pair<double, double>> read_baseline(const std::string& path) {
+    std::map<std::string, std::pair<double, double>> out;
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot read baseline " + path);
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::vector<std::string> f;
+        std::stringstream ss(line);
+        std::string part;
+        while (std::getline(ss, part, ',')) f.push_back(part);
+        if (f.size() < 9) continue;
+        out[f[0] + ',' + f[1] + ',' + f[2] + ',' + f[3] + ',' + f[4] + ',' + f[5]] = {std::stod(f[7]), std::stod(f[8])};
+    }
+    return out;
+}
+
+// Bytes the allocator has handed out, or the resident set where mallinfo2
+// is unavailable.
+static uint64_t heap_bytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    return uint64_t(mi.uordblks) + uint64_t(mi.hblkhd);
+#else
+    long pages = 0, resident = 0;
+    if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(f);
+    }
+    return uint64_t(resident) * uint64_t(::sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Loads each --keys count with each --value_size and reports the store's
+// memory per key (hash table, ordered index, key arena and values) and the
+// rate of same-size overwrites at random keys.
+static void run_footprint(const ComponentConfig& cfg) {
+    using clock = std::chrono::steady_clock;
+    std::ofstream csv;
+    if (!cfg.csv_path.empty()) {
+        csv.open(cfg.csv_path);
+        csv << "keys,value_size,bytes_per_key,value_bytes_per_key,load_s,overwrite_ns,overwrites_per_s\n";
+    }
+    for (int keys : cfg.keys)
+    for (int value_size : cfg.value_sizes) {
+        const int64_t n = std::max(1, keys);
+        const std::size_t vsize = static_cast<std::size_t>(std::max(0, value_size));
+        uint64_t before = heap_bytes();
+        auto t0 = clock::now();
+        auto store = std::make_unique<storageManager>();
+        preload(*store, n, value_size);
+        double load_s = std::chrono::duration<double>(clock::now() - t0).count();
+        uint64_t after = heap_bytes();
+        ValueSlabStats vs = store->valueStats();
+
+        // Probe handles are made after measuring, so they are not counted.
+        constexpr std::size_t kProbe = 1 << 20;
+        std::vector<tuple*> targets;
+        targets.reserve(kProbe);
+        std::mt19937_64 rng(19);
+        std::uniform_int_distribution<int64_t> dist(0, n - 1);
+        for (std::size_t i = 0; i < kProbe; ++i) {
+            std::string k = key_name(dist(rng));
+            targets.push_back(store->get(k));
+        }
+        const std::string values[2] = {std::string(vsize, 'a'), std::string(vsize, 'b')};
+        const uint64_t ops = std::max<uint64_t>(kProbe, std::min<uint64_t>(uint64_t(n), uint64_t(1) << 24));
+        auto t1 = clock::now();
+        for (uint64_t i = 0; i < ops; ++i) store->write(targets[i % kProbe], values[i & 1], i);
+        double write_ns = std::chrono::duration<double, std::nano>(clock::now() - t1).count() / double(ops);
+
+        double per_key = after > before ? double(after - before) / double(n) : 0.0;
+        double value_per_key = double(vs.reservedBytes) / double(n);
+        std::cout << "footprint keys=" << n << " value_size=" << vsize << std::fixed << std::setprecision(1)
+                  << "  bytes/key=" << per_key << " (values out of line: " << value_per_key << ")"
+                  << "  load=" << std::setprecision(2) << load_s << "s"
+                  << "  overwrite=" << std::setprecision(1) << write_ns << " ns ("
+                  << std::setprecision(2) << (1e3 / write_ns) << " M/s)"
+                  << std::defaultfloat << std::setprecision(6) << '\n';
+        if (csv) {
+            csv << n << ',' << vsize << ',' << per_key << ',' << value_per_key << ',' << load_s << ','
+                << write_ns << ',' << (1e9 / write_ns) << '\n';
+        }
+    }
+}
+
+static std::vector<int> parse_list(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (!part.empty()) out.push_back(std::stoi(part));
+    }
+    return out;
+}
+
+static std::vector<std::string> parse_names(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (!part.empty()) out.push_back(part);
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    ComponentConfig cfg;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            std::string key = arg.substr(2);
+            std::string val;
+            size_t eq_pos = key.find('=');
+            if (eq_pos != std::string::npos) {
+                val = key.substr(eq_pos + 1);
+                key = key.substr(0, eq_pos);
+            }
+
+            if (key == "bench") {
+                cfg.benches = parse_names(val);
+            } else if (key == "keys") {
+                cfg.keys = parse_list(val);
+            } else if (key == "set_size") {
+                cfg.set_sizes = parse_list(val);
+            } else if (key == "queue_depth") {
+                cfg.queue_depths = parse_list(val);
+            } else if (key == "threads") {
+                cfg.threads = parse_list(val);
+            } else if (key == "value_size") {
+                cfg.value_sizes = parse_list(val);
+            } else if (key == "footprint") {
+                cfg.footprint = (val.empty() || val == "1" || val == "true" || val == "yes");
+            } else if (key == "samples") {
+                cfg.samples = std::stoi(val);
+            } else if (key == "sample_ms") {
+                cfg.sample_ms = std::stoi(val);
+            } else if (key == "csv") {
+                cfg.csv_path = val;
+            } else if (key == "baseline") {
+                cfg.baseline_path = val;
+            } else if (key == "max_regression_pct") {
+                cfg.max_regression_pct = std::stod(val);
+            } else if (key == "help") {
+                std::cout << "VLL component microbenchmarks\n\n";
+                std::cout << "Usage: " << argv[0] << " [options]\n\n";
+                std::cout << "Options (N,M,... runs every listed value):\n";
+                std::cout << "  --bench=NAME,...       Cases to run (default: all)\n";
+                std::cout << "  --keys=N,...           Records in the store / 2PL key space (default: 100000)\n";
+                std::cout << "  --set_size=N,...       Keys per transaction, all written (default: 10)\n";
+                std::cout << "  --queue_depth=N,...    Transactions already queued (default: 64)\n";
+                std::cout << "  --threads=N,...        Threads running the case at once (default: 1)\n";
+                std::cout << "  --value_size=N,...     Bytes per stored value (default: 16)\n";
+                std::cout << "  --footprint            Report memory per key and overwrite rate for each --keys\n";
+                std::cout << "  --samples=N            Timed samples per case (default: 20)\n";
+                std::cout << "  --sample_ms=N          Target length of one sample (default: 20)\n";
+                std::cout << "  --csv=PATH             Write results as CSV\n";
+                std::cout << "  --baseline=PATH        Compare with a CSV from --csv; exit 1 on a regression\n";
+                std::cout << "  --max_regression_pct=F Slowdown tolerated before the CIs must separate (default: 10)\n";
+                std::cout << "  --help                 Show this help message\n\n";
+                std::cout << "Cases:\n";
+                for (const auto& c : cases()) {
+                    std::cout << "  " << std::left << std::setw(22) << c.name << ' ' << c.description << '\n';
+                }
+                return 0;
+            } else {
+                std::cerr << "Unknown option: " << key << std::endl;
+                std::cerr << "Use --help for usage information\n";
+                return 1;
+            }
+        }
+    }
+
+    for (const auto& b : cfg.benches) {
+        bool known = std::any_of(cases().begin(), cases().end(), [&](const CaseDef& c) { return b == c.name; });
+        if (!known) {
+            std::cerr << "Unknown bench: " << b << "\nUse --help for usage information\n";
+            return 1;
+        }
+    }
+    if (cfg.samples < 2 || cfg.keys.empty() || cfg.set_sizes.empty() || cfg.queue_depths.empty() ||
+        cfg.threads.empty() || cfg.value_sizes.empty()) {
+        std::cerr << "Need at least 2 samples and one value for each parameter\n";
+        return 1;
+    }
+
+    if (cfg.footprint) {
+        run_footprint(cfg);
+        return 0;
+    }
+
+    std::map<std::string, std::pair<double, double>> baseline;
+    if (!cfg.baseline_path.empty()) baseline = read_baseline(cfg.baseline_path);
+
+    std::ofstream csv;
+    if (!cfg.csv_path.empty()) {
+        csv.open(cfg.csv_path);
+        csv << "bench,keys,set_size,queue_depth,threads,value_size,samples,ns_per_op,ci95_ns,median_ns,min_ns\n";
+    }
+
+    int regressions = 0;
+    for (const auto& c : cases()) {
+        if (!cfg.benches.empty() && std::find(cfg.benches.begin(), cfg.benches.end(), c.name) == cfg.benches.end())
+            continue;
+        // Parameters a case ignores are pinned to their first value.
+        auto values = [](bool used, const std::vector<int>& v) { return used ? v : std::vector<int>{v.front()}; };
+        for (int keys : values(c.usesKeys, cfg.keys))
+        for (int set_size : values(c.usesSetSize, cfg.set_sizes))
+        for (int depth : values(c.usesQueueDepth, cfg.queue_depths))
+        for (int threads : values(c.usesThreads, cfg.threads))
+        for (int value_size : values(c.usesValueSize, cfg.value_sizes)) {
+            Params p{std::max(1, keys), std::max(1, set_size), std::max(0, depth), std::max(1, threads),
+                     std::max(0, value_size)};
+            Summary s;
+            {
+                CaseRun run = c.setup(p);
+                s = measure(run, p.threads, cfg);
+            }
+
+            std::cout << std::left << std::setw(20) << c.name << std::right << std::setw(44) << params_label(c, p)
+                      << std::fixed << std::setprecision(1)
+                      << "  " << std::setw(10) << s.mean << " ns/op +-" << s.ci95
+                      << " (" << (s.mean > 0 ? 100.0 * s.ci95 / s.mean : 0.0) << "%)"
+                      << "  median=" << s.median << " min=" << s.min;
+
+            std::string rk = result_key(c.name, p);
+            auto it = baseline.find(rk);
+            if (it != baseline.end()) {
+                double base = it->second.first, base_ci = it->second.second;
+                double change = base > 0 ? 100.0 * (s.mean - base) / base : 0.0;
+                // Slower beyond the tolerance, and not explained by noise.
+                bool regressed = change > cfg.max_regression_pct && s.mean - s.ci95 > base + base_ci;
+                std::cout << "  vs baseline " << std::showpos << change << std::noshowpos << "%"
+                          << (regressed ? " REGRESSION" : "");
+                if (regressed) ++regressions;
+            }
+            std::cout << std::defaultfloat << std::setprecision(6) << '\n';
+
+            if (csv) {
+                csv << rk << ',' << s.samples << ',' << s.mean << ',' << s.ci95 << ',' << s.median << ','
+                    << s.min << '\n';
+            }
+        }
+    }
+
+    if (regressions) {
+        std::cerr << regressions << " regression(s) against " << cfg.baseline_path << '\n';
+        return 1;
+    }
+    return 0;
+}
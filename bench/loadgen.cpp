@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/core/vll_stman.h"
+#include "../src/concurrency/vll.h"
+#include "../src/network/protocol.h"
+#include "../src/network/server.h"
+
+// Closed-loop load generator for Server. Each connection pipelines up to
+// `window` requests and records the time from send to ack, so latency
+// includes the loopback hop, the queue and commit.
+struct LoadConfig {
+    std::string host = "127.0.0.1";
+    int port = 0;               // 0 starts an in-process server on an ephemeral port
+    int connections = 4;
+    int window = 1;             // Requests in flight per connection
+    int duration_seconds = 5;
+
+    int hot_keys = 100;
+    int key_space = 100000;
+    int reads_per_tx = 0;
+    int writes_per_tx = 10;
+
+    // In-process server only
+    int io_threads = 2;
+    int workers = 2;
+    int work_us = 0;            // Simulated work per transaction
+    bool use_sca = true;
+};
+
+static std::string key_name(int64_t idx) { return "k" + std::to_string(idx); }
+
+// Fills keys (which must outlive the returned request) and returns a
+// request viewing them.
+template <class URNG>
+static Protocol::SubmitRequest gen_request(const LoadConfig& cfg, URNG& rng, uint64_t tag,
+                                           std::vector<std::string>& reads, std::vector<std::string>& writes) {
+    reads.clear();
+    writes.clear();
+    int64_t hot = std::max(1, cfg.hot_keys);
+    std::uniform_int_distribution<int64_t> hot_dist(0, hot - 1);
+    std::uniform_int_distribution<int64_t> cold_dist(std::min<int64_t>(hot, cfg.key_space - 1),
+                                                     std::max<int64_t>(hot, cfg.key_space - 1));
+    if (cfg.writes_per_tx > 0) writes.push_back(key_name(hot_dist(rng)));
+    for (int i = 1; i < cfg.writes_per_tx; ++i) writes.push_back(key_name(cold_dist(rng)));
+    for (int i = 0; i < cfg.reads_per_tx; ++i) reads.push_back(key_name(cold_dist(rng)));
+
+    std::sort(writes.begin(), writes.end());
+    writes.erase(std::unique(writes.begin(), writes.end()), writes.end());
+    std::sort(reads.begin(), reads.end());
+    reads.erase(std::unique(reads.begin(), reads.end()), reads.end());
+    reads.erase(std::remove_if(reads.begin(), reads.end(), [&](const std::string& k){
+        return std::binary_search(writes.begin(), writes.end(), k);
+    }), reads.end());
+
+    Protocol::SubmitRequest req;
+    req.tag = tag;
+    req.reads.assign(reads.begin(), reads.end());
+    req.writes.assign(writes.begin(), writes.end());
+    return req;
+}
+
+static int connect_to(const std::string& host, int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 ||
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static bool send_all(int fd, const char* p, std::size_t n) {
+    while (n > 0) {
+        ssize_t w = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+struct ClientResult {
+    std::vector<double> latencies_us;
+    long committed = 0;
+    long aborted = 0;
+    bool failed = false;
+};
+
+static void run_client(const LoadConfig& cfg, int port, int id,
+                       std::chrono::steady_clock::time_point end, ClientResult& res) {
+    using clock = std::chrono::steady_clock;
+    int fd = connect_to(cfg.host, port);
+    if (fd < 0) {
+        res.failed = true;
+        return;
+    }
+
+    std::mt19937_64 rng(id + 789);
+    std::unordered_map<uint64_t, clock::time_point> inflight;
+    std::vector<char> out;
+    std::vector<char> in;
+    std::vector<char> buf(64 << 10);
+    std::vector<std::string> reads, writes;
+    uint64_t next_tag = 1;
+
+    while (true) {
+        bool sending = clock::now() < end;
+        if (!sending && inflight.empty()) break;
+
+        out.clear();
+        while (sending && inflight.size() < static_cast<std::size_t>(cfg.window)) {
+            uint64_t tag = next_tag++;
+            Protocol::encodeSubmit(gen_request(cfg, rng, tag, reads, writes), out);
+            inflight.emplace(tag, clock::now());
+        }
+        if (!out.empty() && !send_all(fd, out.data(), out.size())) {
+            res.failed = true;
+            break;
+        }
+
+        ssize_t n = ::recv(fd, buf.data(), buf.size(), 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            res.failed = true;
+            break;
+        }
+        in.insert(in.end(), buf.data(), buf.data() + n);
+
+        std::size_t parsed = 0;
+        auto now = clock::now();
+        while (true) {
+            long size = Protocol::frameSize(in.data() + parsed, in.size() - parsed);
+            if (size == 0) break;
+            Protocol::Ack ack;
+            if (size < 0 || !Protocol::decodeAck(in.data() + parsed, static_cast<std::size_t>(size), ack)) {
+                res.failed = true;
+                break;
+            }
+            parsed += static_cast<std::size_t>(size);
+            auto it = inflight.find(ack.tag);
+            if (it == inflight.end()) continue;
+            res.latencies_us.push_back(std::chrono::duration<double, std::micro>(now - it->second).count());
+            inflight.erase(it);
+            if (ack.status == static_cast<uint8_t>(ConcVLL::TxnStatus::Committed)) ++res.committed;
+            else ++res.aborted;
+        }
+        if (res.failed) break;
+        in.erase(in.begin(), in.begin() + static_cast<std::ptrdiff_t>(parsed));
+    }
+    ::close(fd);
+}
+
+int main(int argc, char** argv) {
+    LoadConfig cfg;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            std::string key = arg.substr(2);
+            std::string val;
+            size_t eq_pos = key.find('=');
+            if (eq_pos != std::string::npos) {
+                val = key.substr(eq_pos + 1);
+                key = key.substr(0, eq_pos);
+            }
+
+            if (key == "host") {
+                cfg.host = val;
+            } else if (key == "port") {
+                cfg.port = std::stoi(val);
+            } else if (key == "connections") {
+                cfg.connections = std::stoi(val);
+            } else if (key == "window") {
+                cfg.window = std::stoi(val);
+            } else if (key == "duration_seconds") {
+                cfg.duration_seconds = std::stoi(val);
+            } else if (key == "hot_keys") {
+                cfg.hot_keys = std::stoi(val);
+            } else if (key == "key_space") {
+                cfg.key_space = std::stoi(val);
+            } else if (key == "reads_per_tx") {
+                cfg.reads_per_tx = std::stoi(val);
+            } else if (key == "writes_per_tx") {
+                cfg.writes_per_tx = std::stoi(val);
+            } else if (key == "io_threads") {
+                cfg.io_threads = std::stoi(val);
+            } else if (key == "workers") {
+                cfg.workers = std::stoi(val);
+            } else if (key == "work_us") {
+                cfg.work_us = std::stoi(val);
+            } else if (key == "use_sca") {
+                cfg.use_sca = (val == "1" || val == "true" || val == "yes");
+            } else if (key == "help") {
+                std::cout << "VLL network load generator\n\n";
+                std::cout << "Usage: " << argv[0] << " [options]\n\n";
+                std::cout << "Options:\n";
+                std::cout << "  --host=ADDR            Server address (default: 127.0.0.1)\n";
+                std::cout << "  --port=N               Server port; 0 starts an in-process server (default: 0)\n";
+                std::cout << "  --connections=N        Client connections, one thread each (default: 4)\n";
+                std::cout << "  --window=N             Requests in flight per connection (default: 1)\n";
+                std::cout << "  --duration_seconds=N   Duration (default: 5)\n";
+                std::cout << "  --hot_keys=N           Number of hot keys (default: 100)\n";
+                std::cout << "  --key_space=N          Total key space size (default: 100000)\n";
+                std::cout << "  --reads_per_tx=N       Reads per transaction (default: 0)\n";
+                std::cout << "  --writes_per_tx=N      Writes per transaction (default: 10)\n";
+                std::cout << "  --io_threads=N         In-process server: I/O threads (default: 2)\n";
+                std::cout << "  --workers=N            In-process server: VLL workers (default: 2)\n";
+                std::cout << "  --work_us=N            In-process server: simulated work per txn (default: 0)\n";
+                std::cout << "  --use_sca=BOOL         In-process server: enable SCA (default: true)\n";
+                std::cout << "  --help                 Show this help message\n";
+                return 0;
+            } else {
+                std::cerr << "Unknown option: " << key << std::endl;
+                std::cerr << "Use --help for usage information\n";
+                return 1;
+            }
+        }
+    }
+
+    storageManager store;
+    ConcVLL::TxnQueue queue;
+    std::unique_ptr<Server> server;
+    int port = cfg.port;
+    if (port == 0) {
+        for (int64_t i = 0; i < cfg.key_space; ++i) {
+            std::string k = key_name(i);
+            store.insert(k, std::string());
+        }
+        ServerOptions so;
+        so.host = cfg.host;
+        so.ioThreads = cfg.io_threads;
+        so.workers = cfg.workers;
+        so.enable_sca = cfg.use_sca;
+        auto exec = [&cfg](ConcVLL::txn_ptr){
+            if (cfg.work_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(cfg.work_us));
+        };
+        server = std::make_unique<Server>(store, queue, exec, so);
+        server->start();
+        port = server->port();
+        std::cout << "Started in-process server on " << cfg.host << ":" << port << '\n';
+    }
+
+    std::cout << "Running load: connections=" << cfg.connections << " window=" << cfg.window
+              << " duration=" << cfg.duration_seconds << "s hot_keys=" << cfg.hot_keys
+              << " writes_per_tx=" << cfg.writes_per_tx << " reads_per_tx=" << cfg.reads_per_tx << '\n';
+
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::seconds(cfg.duration_seconds);
+    std::vector<ClientResult> results(static_cast<std::size_t>(cfg.connections));
+    std::vector<std::thread> clients;
+    for (int i = 0; i < cfg.connections; ++i) {
+        clients.emplace_back(run_client, std::cref(cfg), port, i, end, std::ref(results[static_cast<std::size_t>(i)]));
+    }
+    for (auto& t : clients) t.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> lat;
+    long committed = 0, aborted = 0, failed = 0;
+    for (auto& r : results) {
+        lat.insert(lat.end(), r.latencies_us.begin(), r.latencies_us.end());
+        committed += r.committed;
+        aborted += r.aborted;
+        failed += r.failed ? 1 : 0;
+    }
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&](double p) {
+        if (lat.empty()) return 0.0;
+        std::size_t i = std::min(lat.size() - 1, static_cast<std::size_t>(p * static_cast<double>(lat.size())));
+        return lat[i];
+    };
+    double mean = 0.0;
+    for (double v : lat) mean += v;
+    if (!lat.empty()) mean /= static_cast<double>(lat.size());
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Committed txns: " << committed << " (" << (committed / elapsed) << " tps)"
+              << ", aborted=" << aborted << ", failed connections=" << failed << '\n';
+    std::cout << "Latency us: mean=" << mean << " p50=" << pct(0.50) << " p90=" << pct(0.90)
+              << " p99=" << pct(0.99) << " p99.9=" << pct(0.999)
+              << " max=" << (lat.empty() ? 0.0 : lat.back()) << '\n';
+
+    if (server) {
+        auto ss = server->stats();
+        server->stop();
+        std::cout << "Server: connections=" << ss.connections << " requests=" << ss.requests
+                  << " rejected=" << ss.rejected << " acks=" << ss.acks << " batches=" << ss.batches;
+        if (ss.batches > 0) std::cout << " requests/batch=" << (double(ss.requests) / double(ss.batches));
+        if (ss.sends > 0) std::cout << " acks/send=" << (double(ss.acks) / double(ss.sends));
+        std::cout << " rx_blocks=" << ss.rxBlocksAllocated << " (reused " << ss.rxBlocksReused << ")\n";
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -2,21 +2,34 @@
 #include <chrono>
 #include <condition_variable>
 #include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <memory>
 #include <mutex>
 #include <random>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 #include <unordered_set>
 #include <ctime>
+#include <sys/stat.h>
 
 #include "../src/core/vll_stman.h"
 #include "../src/concurrency/vll.h"
 #include "../src/concurrency/lock_manager_2pl.h"
+#include "../src/concurrency/hybrid.h"
+#include "../src/concurrency/sequencer.h"
+#include "../src/concurrency/trace.h"
+#include "../src/replication/replication.h"
 #include "../src/transaction/transaction.h"
+#include "../src/durability/command_log.h"
+#include "../src/durability/recovery.h"
+#include "../src/core/checkpoint.h"
+#include "../src/core/topology.h"
+#include "perf_counters.h"
 
 using namespace std::chrono_literals;
 
@@ -25,19 +38,53 @@ struct BenchConfig {
     int duration_seconds = 5;
 
     int hot_keys = 100;         // Number of hot keys (Contention Index = 1 / hot_keys)
+    bool hot_updates = false;   // Hot-key writes become commutative increments (2PL and VLL)
     int key_space = 1000000;    // Total number of keys in the database
     int reads_per_tx = 0;       // Number of reads per transaction
     int writes_per_tx = 10;      // Number of writes per transaction
     int work_us = 160;          // How long in microseconds each transaction "works"
     bool use_sca = true;        // Enable Selective Contention Analysis (per VLL paper Section 2.5)
+    std::string unblock_policy = "paper";  // "paper" (SCA only on a full queue) or "adaptive"
+    double sca_blocked_ratio = 0.25;       // Adaptive policy: blocked fraction that triggers SCA
+    int sca_min_depth = 64;                // Adaptive policy: SCA scan depth on a cold hit rate
+    std::string log_path;       // Command log file for VLL; empty keeps everything in memory
+    std::string log_sync = "group";  // "none", "periodic" or "group"
+    int group_commit_us = 200;  // How long the log thread lets a batch grow
+    bool verify_recovery = false;    // After the logged VLL run, replay the log and compare state
+    std::string recover_from;   // Only replay this command log and report recovery time
+    std::string checkpoint_path;     // Start VLL from this snapshot (written on first use)
+    bool checkpoint_during_run = false;  // Take a copy-on-write checkpoint halfway through the VLL run
+    int scan_pct = 0;           // Percent of VLL transactions that are range scans
+    int scan_keys = 1000;       // Approximate number of keys per scan
+    int read_only_pct = 0;      // Percent of transactions that only read (2PL and VLL)
+    bool mvcc = true;           // VLL: run read-only transactions on snapshots instead of the queue
+    int epoch_us = 0;           // VLL: sequence submissions into epochs of this length; 0 admits directly
+    int max_inflight = 0;       // VLL: cap on submitted but unfinished transactions; 0 is unbounded
+                                // (kBoundedInflight for sequenced and hybrid runs)
+    int replicas = 0;           // VLL: replicas fed the primary's sequenced epochs
+    std::string replica_transport = "inproc";  // "inproc" or "unix"
+    std::string pin = "none";   // Thread placement: "none", "compact" or "scatter"
+    bool perf = false;          // Collect perf_event counters on the 2PL/VLL worker threads
+    std::string trace_path;     // VLL: write a Chrome trace of the run's transaction lifecycle here
+    bool hybrid = false;        // Compare fixed VLL, fixed 2PL and the adaptive hybrid over phases
+    std::string phases = "hot_keys=100,writes_per_tx=10,work_us=1000;hot_keys=8,writes_per_tx=4,work_us=1000;"
+                         "hot_keys=100,writes_per_tx=10,work_us=1000;hot_keys=8,writes_per_tx=4,work_us=1000";
     bool sweep = false;         // Run contention sweep for graphing
     std::string output_prefix = "benchmark_results";  // Output file prefix for sweep mode
     bool quiet = false;         // Suppress per-second output
 };
 
+// --max_inflight when unset for runs that admit through BeginBatch (the
+// sequencer, hybrid), where an unbounded backlog only measures queueing.
+constexpr int kBoundedInflight = 1024;
+
 static std::string key_name(int64_t idx) { return "k" + std::to_string(idx); }
 
-struct TxSets { std::vector<std::string> reads; std::vector<std::string> writes; };
+struct TxSets {
+    std::vector<std::string> reads;
+    std::vector<std::string> writes;
+    std::vector<ConcVLL::UpdateSpec> updates;
+};
 
 template <class URNG>
 static TxSets gen_tx_sets(const BenchConfig& cfg, URNG& rng) {
@@ -50,7 +97,8 @@ static TxSets gen_tx_sets(const BenchConfig& cfg, URNG& rng) {
 
         std::uniform_int_distribution<int> hot_dist(0, cfg.hot_keys - 1);
         int64_t hot_k = hot_dist(rng);
-        out.writes.push_back(key_name(hot_k));
+        if (cfg.hot_updates) out.updates.push_back(ConcVLL::UpdateSpec{key_name(hot_k), UpdateOp::Add, 1});
+        else out.writes.push_back(key_name(hot_k));
 
         int64_t cold_begin = static_cast<int64_t>(cfg.hot_keys);
         int64_t cold_end = std::max<int64_t>(cold_begin + 1, static_cast<int64_t>(cfg.key_space) - 1);
@@ -84,7 +132,182 @@ static TxSets gen_tx_sets(const BenchConfig& cfg, URNG& rng) {
     return out;
 }
 
-long run_2pl(const BenchConfig& cfg) {
+// Read-only transaction over the same keys (hot key included) that a
+// read-write transaction would touch.
+template <class URNG>
+static TxSets gen_read_only_sets(const BenchConfig& cfg, URNG& rng) {
+    TxSets out = gen_tx_sets(cfg, rng);
+    out.reads.insert(out.reads.end(), out.writes.begin(), out.writes.end());
+    out.writes.clear();
+    for (auto& u : out.updates) out.reads.push_back(std::move(u.key));
+    out.updates.clear();
+    std::sort(out.reads.begin(), out.reads.end());
+    return out;
+}
+
+// Prefix range ["k<p>", "k<p>~"], i.e. key <p> and every key extending it.
+// Prefixes are drawn with the same number of digits so each covers roughly
+// scan_keys keys of the key space.
+template <class URNG>
+static ConcVLL::KeyRange gen_scan_range(const BenchConfig& cfg, URNG& rng) {
+    int64_t n = std::max<int64_t>(1, cfg.key_space / std::max(1, cfg.scan_keys));
+    std::uniform_int_distribution<int64_t> dist(n >= 10 ? n / 10 : 0, n - 1);
+    std::string lo = key_name(dist(rng));
+    return ConcVLL::KeyRange{lo, lo + "~"};
+}
+
+// With worker CPUs given, the key space is split into one contiguous slice
+// per NUMA node those workers use, and each slice is inserted from a thread
+// bound to that node so its records are first touched there. Slices are
+// loaded one after another; the store is not safe for concurrent inserts.
+static void preload(storageManager& store, const BenchConfig& cfg, const std::vector<int>& cpus = {}) {
+    std::vector<int> node_cpus;
+    if (!cpus.empty() && cpus.front() >= 0) {
+        CpuTopology topo = CpuTopology::detect();
+        std::vector<int> seen;
+        for (int c : cpus) {
+            int node = nodeOfCpu(topo, c);
+            if (std::find(seen.begin(), seen.end(), node) == seen.end()) {
+                seen.push_back(node);
+                node_cpus.push_back(c);
+            }
+        }
+    }
+    if (node_cpus.empty()) {
+        for (int64_t i = 0; i < cfg.key_space; ++i) {
+            std::string k = key_name(i);
+            store.insert(k, std::string());
+        }
+        return;
+    }
+    int64_t slice = (cfg.key_space + int64_t(node_cpus.size()) - 1) / int64_t(node_cpus.size());
+    for (std::size_t n = 0; n < node_cpus.size(); ++n) {
+        int64_t lo = int64_t(n) * slice;
+        int64_t hi = std::min<int64_t>(cfg.key_space, lo + slice);
+        runPinned(node_cpus[n], [&]{
+            for (int64_t i = lo; i < hi; ++i) {
+                std::string k = key_name(i);
+                store.insert(k, std::string());
+            }
+        });
+    }
+}
+
+// Loads cfg.checkpoint_path if it exists, otherwise preloads the key space
+// (writing the checkpoint for the next start when a path is set). Returns
+// the id of the last transaction reflected in the loaded state.
+static uint64_t startup(storageManager& store, const BenchConfig& cfg, const char* label,
+                        const std::vector<int>& worker_cpus = {}) {
+    auto t0 = std::chrono::steady_clock::now();
+    struct stat st;
+    if (!cfg.checkpoint_path.empty() && ::stat(cfg.checkpoint_path.c_str(), &st) == 0) {
+        auto info = Checkpoint::load(store, cfg.checkpoint_path);
+        if (!cfg.quiet) {
+            std::cout << label << " startup: loaded checkpoint (" << info.records << " records, boundary="
+                      << info.boundaryId << ") in " << info.seconds << "s\n";
+        }
+        return info.boundaryId;
+    }
+
+    preload(store, cfg, worker_cpus);
+    if (!cfg.quiet) {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - t0;
+        std::cout << label << " startup: preloaded " << cfg.key_space << " keys in " << d.count() << "s\n";
+    }
+    if (!cfg.checkpoint_path.empty()) {
+        auto info = Checkpoint::write(store, cfg.checkpoint_path);
+        if (!cfg.quiet) {
+            std::cout << label << " wrote checkpoint " << cfg.checkpoint_path << " (" << info.bytes
+                      << " bytes) in " << info.seconds << "s\n";
+        }
+    }
+    return 0;
+}
+
+// Deterministic transaction body: every written value depends on the txn id,
+// the values read and the previous value, so replaying in any order other
+// than the queue order ends in a different store.
+static void apply_txn(storageManager& store, const ConcVLL::Transaction& t) {
+    std::hash<std::string_view> hasher;
+    uint64_t h = t.id;
+    if (t.snapshotRead) {
+        for (const auto& k : t.ReadSet) {
+            if (const std::string* v = store.readAt(k, t.readTs)) h = h * 31 + hasher(*v);
+        }
+        return;
+    }
+    // VLL admission already looked the records up; 2PL looks them up here.
+    auto record = [&](const std::vector<tuple*>& recs, std::size_t i, const KeyHandle& k) {
+        return i < recs.size() ? recs[i] : store.get(k);
+    };
+    for (std::size_t i = 0; i < t.ReadSet.size(); ++i) {
+        if (tuple* r = record(t.ReadRecords, i, t.ReadSet[i])) h = h * 31 + hasher(r->value.view()) + uint64_t(r->num.load());
+    }
+    // The keys the scan locked at admission. Keys created in its ranges since
+    // then belong to newer txns and must not be read.
+    for (std::string_view k : t.RangeKeys) {
+        if (tuple* v = store.find(k)) h = h * 31 + hasher(v->value.view());
+    }
+    for (std::size_t i = 0; i < t.WriteSet.size(); ++i) {
+        if (tuple* w = record(t.WriteRecords, i, t.WriteSet[i])) {
+            char buf[24];
+            auto end = std::to_chars(buf, buf + sizeof(buf), h ^ hasher(w->value.view())).ptr;
+            store.write(w, std::string_view(buf, end - buf), t.id);
+        }
+    }
+    // Commutative, so the result does not depend on h or on the order of
+    // concurrent updaters.
+    for (std::size_t i = 0; i < t.UpdateSet.size(); ++i) {
+        const auto& u = t.UpdateSet[i];
+        if (tuple* c = record(t.UpdateRecords, i, u.key)) store.update(c, u.op, u.operand, t.id);
+    }
+}
+
+static const char* const kPerfNames[kPerfEvents] = {
+    "cycles", "instructions", "llc_misses", "branch_misses", "ctx_switches"
+};
+
+static void print_perf(const char* label, const PerfSample& s, long committed) {
+    if (s.threads == 0 || committed <= 0) return;
+    double n = double(committed);
+    std::cout << label << " perf (" << s.threads << " worker threads): cpu_ns/tx=" << (double(s.cpuNs) / n);
+    if (!s.any()) {
+        std::cout << ", hardware counters unavailable (check /proc/sys/kernel/perf_event_paranoid)\n";
+        return;
+    }
+    for (int i = 0; i < kPerfEvents; ++i) {
+        std::cout << ", " << kPerfNames[i] << "/tx=";
+        if (s.valid[i]) std::cout << (double(s.value[i]) / n);
+        else std::cout << "n/a";
+    }
+    if (s.valid[kCycles] && s.valid[kInstructions] && s.value[kCycles])
+        std::cout << ", ipc=" << (double(s.value[kInstructions]) / double(s.value[kCycles]));
+    std::cout << '\n';
+}
+
+// Per-transaction perf columns for the sweep CSVs; unavailable events are
+// left empty.
+static std::string perf_csv_header() {
+    std::string h = ",cpu_ns_per_tx";
+    for (int i = 0; i < kPerfEvents; ++i) h += std::string(",") + kPerfNames[i] + "_per_tx";
+    return h + ",ipc";
+}
+
+static std::string perf_csv_row(const PerfSample& s, long committed) {
+    std::ostringstream os;
+    double n = committed > 0 ? double(committed) : 1.0;
+    os << ',' << (double(s.cpuNs) / n);
+    for (int i = 0; i < kPerfEvents; ++i) {
+        os << ',';
+        if (s.valid[i]) os << (double(s.value[i]) / n);
+    }
+    os << ',';
+    if (s.valid[kCycles] && s.valid[kInstructions] && s.value[kCycles])
+        os << (double(s.value[kInstructions]) / double(s.value[kCycles]));
+    return os.str();
+}
+
+long run_2pl(const BenchConfig& cfg, PerfSample* perf = nullptr) {
     LockManager2PL lm;
     std::atomic<long> committed{0};
     std::atomic<bool> stop{false};
@@ -92,21 +315,33 @@ long run_2pl(const BenchConfig& cfg) {
     std::vector<std::atomic<long>> per_thread_committed(cfg.num_threads);
     for (auto &c : per_thread_committed) c.store(0);
 
+    auto cpus = placementPlan(CpuTopology::detect(), parsePinStrategy(cfg.pin), cfg.num_threads);
+
+    PerfTotals perf_totals;
+
     auto worker = [&](int id){
+        pinThisThread(cpus[id]);
+        std::unique_ptr<ThreadPerfCounters> pc;
+        if (cfg.perf) pc = std::make_unique<ThreadPerfCounters>();
         std::mt19937_64 rng(id + 123);
+        std::uniform_int_distribution<int> pct(0, 99);
 
         while (!stop.load()) {
-            auto sets = gen_tx_sets(cfg, rng);
-            auto& reads = sets.reads;
-            auto& writes = sets.writes;
-
-            lm.acquire_all_atomically(reads, writes);
+            bool read_only = cfg.read_only_pct > 0 && pct(rng) < cfg.read_only_pct;
+            auto sets = read_only ? gen_read_only_sets(cfg, rng) : gen_tx_sets(cfg, rng);
+            std::vector<KeyHandle> reads(sets.reads.begin(), sets.reads.end());
+            std::vector<KeyHandle> writes(sets.writes.begin(), sets.writes.end());
+            std::vector<CommutativeUpdate> updates;
+            for (const auto& u : sets.updates) updates.push_back(CommutativeUpdate{u.key, u.op, u.operand});
+
+            lm.acquire_all_atomically(reads, writes, updates);
             std::this_thread::sleep_for(std::chrono::microseconds(cfg.work_us));
-            lm.release_all(reads, writes);
+            lm.release_all(reads, writes, updates);
 
             committed.fetch_add(1, std::memory_order_relaxed);
             per_thread_committed[id].fetch_add(1, std::memory_order_relaxed);
         }
+        if (pc) perf_totals.add(pc->read());
     };
 
     std::vector<std::thread> threads;
@@ -139,19 +374,60 @@ long run_2pl(const BenchConfig& cfg) {
     if (committed_count > 0 && !cfg.quiet) {
         double ns_per_tx = (cpu_seconds / double(committed_count)) * 1e9;
         std::cout << "[2PL] CPU time=" << cpu_seconds << "s, per-tx=" << ns_per_tx << " ns\n";
+        auto lc = lm.counters();
+        std::cout << "[2PL] locks: acquires=" << lc.acquires << ", waits=" << lc.waits
+                  << ", wait_ms=" << (lc.waitNs / 1000000) << ", notifies=" << lc.notifies
+                  << ", wakeups=" << lc.wakeups << " (futile=" << lc.futileWakeups << ")\n";
+        print_perf("[2PL]", perf_totals.total(), committed_count);
     }
+    if (perf) *perf = perf_totals.total();
 
     return committed_count;
 }
 
-long run_vll(const BenchConfig& cfg) {
+// Submission time for submit-to-commit latency.
+struct BenchTxn : ConcVLL::Transaction {
+    std::chrono::steady_clock::time_point submitted;
+    int phase = 0;              // hybrid runs: workload phase it was generated in
+};
+
+static double percentile(std::vector<uint32_t>& v, double p) {
+    if (v.empty()) return 0.0;
+    std::size_t i = std::min(v.size() - 1, static_cast<std::size_t>(p * double(v.size())));
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+}
+
+long run_vll(const BenchConfig& cfg, uint64_t* final_checksum = nullptr, PerfSample* perf = nullptr) {
     storageManager store;
     ConcVLL::TxnQueue q;
     std::atomic<long> committed{0};
+    std::atomic<long> committed_read_only{0};
+    std::atomic<long> inflight{0};
     std::atomic<bool> stop{false};
+    std::mutex lat_m;
+    std::vector<uint32_t> latencies_us;
+
+    const char* vll_label = cfg.use_sca ? "[VLL+SCA]" : "[VLL]";
+    // Workers take the first num_threads CPUs of the plan, producers the next.
+    auto cpus = placementPlan(CpuTopology::detect(), parsePinStrategy(cfg.pin), 2 * cfg.num_threads);
+    q.resumeAfter(startup(store, cfg, vll_label,
+                          std::vector<int>(cpus.begin(), cpus.begin() + cfg.num_threads)));
+
+    if (cfg.mvcc && cfg.read_only_pct > 0) {
+        store.enableVersioning();
+        store.startVersionGC(10ms);
+    }
 
-    for (int64_t i = 0; i < cfg.key_space; ++i) {
-        store.insert(key_name(i), std::string());
+    std::unique_ptr<ConcVLL::CommandLog> log;
+    if (!cfg.log_path.empty()) {
+        ConcVLL::CommandLogOptions lo;
+        lo.sync = cfg.log_sync == "none" ? ConcVLL::LogSyncPolicy::None
+                : cfg.log_sync == "periodic" ? ConcVLL::LogSyncPolicy::Periodic
+                : ConcVLL::LogSyncPolicy::GroupCommit;
+        lo.groupCommitInterval = std::chrono::microseconds(cfg.group_commit_us);
+        log = std::make_unique<ConcVLL::CommandLog>(cfg.log_path, lo);
+        q.setCommandLog(log.get());
     }
 
     auto wall_start = std::chrono::steady_clock::now();
@@ -161,7 +437,49 @@ long run_vll(const BenchConfig& cfg) {
     std::mutex req_m;
     std::condition_variable req_cv;
 
+    // Replicas start from the same preload or checkpoint and run the same
+    // transaction logic, each on its own store and worker threads.
+    ConcVLL::ReplicationPrimary primary;
+    std::vector<std::unique_ptr<storageManager>> replica_stores;
+    std::vector<std::unique_ptr<ConcVLL::Replica>> replicas;
+    for (int i = 0; i < cfg.replicas; ++i) {
+        replica_stores.push_back(std::make_unique<storageManager>());
+        storageManager& rs = *replica_stores.back();
+        startup(rs, cfg, "[Replica]");
+        auto ends = cfg.replica_transport == "unix" ? ConcVLL::UnixSocketTransport::pair()
+                                                    : ConcVLL::InProcessTransport::pair();
+        primary.addReplica(std::move(ends.first));
+        ConcVLL::ReplicaOptions ro;
+        ro.workers = cfg.num_threads;
+        ro.enable_sca = cfg.use_sca;
+        replicas.push_back(std::make_unique<ConcVLL::Replica>(rs, std::move(ends.second),
+            [&rs, &cfg](ConcVLL::txn_ptr t){
+                apply_txn(rs, *t);
+                std::this_thread::sleep_for(std::chrono::microseconds(cfg.work_us));
+            }, ro));
+        replicas.back()->start();
+    }
+
+    std::unique_ptr<ConcVLL::Sequencer> sequencer;
+    int epoch_us = 0;
+    if (cfg.epoch_us > 0 || cfg.replicas > 0) {
+        ConcVLL::SequencerOptions so;
+        if (cfg.epoch_us > 0) so.epoch = std::chrono::microseconds(cfg.epoch_us);
+        so.maxQueueSize = 10000;
+        epoch_us = static_cast<int>(so.epoch.count());
+        sequencer = std::make_unique<ConcVLL::Sequencer>(q, store, so);
+        if (!replicas.empty()) {
+            sequencer->setBatchHandler([&primary](uint64_t epoch, const std::vector<ConcVLL::txn_ptr>& b){
+                primary.ship(epoch, b);
+            });
+        }
+        sequencer->start();
+    }
+
+    const int max_inflight = cfg.max_inflight > 0 ? cfg.max_inflight : (sequencer ? kBoundedInflight : 0);
+
     auto getNew = [&]() -> ConcVLL::txn_ptr {
+        if (sequencer) return nullptr;
         std::unique_lock<std::mutex> lk(req_m);
         if (std::chrono::steady_clock::now() > wall_end) return nullptr;
         req_cv.wait_for(lk, 50ms, [&]{ return !reqs.empty() || stop.load(); });
@@ -171,23 +489,74 @@ long run_vll(const BenchConfig& cfg) {
     };
 
     auto exec = [&](ConcVLL::txn_ptr t){
+        apply_txn(store, *t);
         std::this_thread::sleep_for(std::chrono::microseconds(cfg.work_us));
-        committed.fetch_add(1, std::memory_order_relaxed);
     };
 
+    // Counted on completion, after the command log has made the txn durable,
+    // so logged runs report acknowledged commits and their full latency.
+    q.setCompletionHandler([&](const ConcVLL::txn_ptr& t){
+        inflight.fetch_sub(1, std::memory_order_relaxed);
+        if (t->status != ConcVLL::TxnStatus::Committed) return;
+        committed.fetch_add(1, std::memory_order_relaxed);
+        if (t->WriteSet.empty() && t->UpdateSet.empty() && t->ReadRanges.empty())
+            committed_read_only.fetch_add(1, std::memory_order_relaxed);
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - static_cast<BenchTxn&>(*t).submitted).count();
+        std::lock_guard<std::mutex> lg(lat_m);
+        latencies_us.push_back(static_cast<uint32_t>(us));
+    });
+
+    if (cfg.use_sca && cfg.unblock_policy == "adaptive") {
+        ConcVLL::AdaptivePolicy::Config pc;
+        pc.blockedRatio = cfg.sca_blocked_ratio;
+        pc.minScanDepth = static_cast<std::size_t>(cfg.sca_min_depth);
+        q.setUnblockPolicy(std::make_shared<ConcVLL::AdaptivePolicy>(pc));
+    }
+
+    if (!cfg.trace_path.empty()) ConcVLL::Tracer::enable();
+
+    PerfTotals perf_totals;
     std::vector<std::thread> vll_threads;
     vll_threads.reserve(cfg.num_threads);
     for (int i = 0; i < cfg.num_threads; ++i) {
-        vll_threads.emplace_back([&]{ q.VLLMainLoop(store, exec, getNew, [&]{ return stop.load(); }, 10000, cfg.use_sca); });
+        vll_threads.emplace_back([&, i]{
+            pinThisThread(cpus[i]);
+            ConcVLL::Tracer::nameThread("worker " + std::to_string(i));
+            std::unique_ptr<ThreadPerfCounters> pc;
+            if (cfg.perf) pc = std::make_unique<ThreadPerfCounters>();
+            q.VLLMainLoop(store, exec, getNew, [&]{ return stop.load(); }, 10000, cfg.use_sca);
+            if (pc) perf_totals.add(pc->read());
+        });
     }
 
     auto worker = [&](int id){
+        pinThisThread(cpus[cfg.num_threads + id]);
+        ConcVLL::Tracer::nameThread("producer " + std::to_string(id));
         std::mt19937_64 rng(id + 456);
+        std::uniform_int_distribution<int> pct(0, 99);
         while (!stop.load()) {
-            auto tx = std::make_shared<ConcVLL::Transaction>(0);
-            auto sets = gen_tx_sets(cfg, rng);
-            tx->ReadSet = std::move(sets.reads);
-            tx->WriteSet = std::move(sets.writes);
+            if (max_inflight > 0 && inflight.load(std::memory_order_relaxed) >= max_inflight) {
+                std::this_thread::sleep_for(20us);
+                continue;
+            }
+            auto tx = std::make_shared<BenchTxn>();
+            int p = pct(rng);
+            if (cfg.scan_pct > 0 && p < cfg.scan_pct) {
+                tx->ReadRanges.push_back(gen_scan_range(cfg, rng));
+            } else if (cfg.read_only_pct > 0 && p < cfg.scan_pct + cfg.read_only_pct) {
+                auto sets = gen_read_only_sets(cfg, rng);
+                tx->assignKeys(sets.reads, sets.writes);
+            } else {
+                auto sets = gen_tx_sets(cfg, rng);
+                tx->assignKeys(sets.reads, sets.writes, sets.updates);
+            }
+            inflight.fetch_add(1, std::memory_order_relaxed);
+            tx->submitted = std::chrono::steady_clock::now();
+            if (sequencer) {
+                sequencer->submit(tx);
+                continue;
+            }
             {
                 std::lock_guard<std::mutex> lg(req_m);
                 reqs.push_back(tx);
@@ -196,12 +565,12 @@ long run_vll(const BenchConfig& cfg) {
         }
     };
 
+    auto run_start = std::chrono::steady_clock::now();
     std::vector<std::thread> producers;
     for (int i = 0; i < cfg.num_threads; ++i) producers.emplace_back(worker, i);
 
     std::clock_t cpu_start = std::clock();
 
-    const char* vll_label = cfg.use_sca ? "[VLL+SCA]" : "[VLL]";
     std::thread monitor([&, vll_label]{
         for (int s = 0; s < cfg.duration_seconds && !stop.load(); ++s) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -212,7 +581,17 @@ long run_vll(const BenchConfig& cfg) {
         }
     });
 
-    std::this_thread::sleep_for(std::chrono::seconds(cfg.duration_seconds));
+    std::unique_ptr<BackgroundCheckpoint> ckpt;
+    if (cfg.checkpoint_during_run && !cfg.checkpoint_path.empty()) {
+        auto half = std::chrono::milliseconds(cfg.duration_seconds * 500);
+        std::this_thread::sleep_for(half);
+        ckpt = std::make_unique<BackgroundCheckpoint>(store, cfg.checkpoint_path);
+        auto boundary = q.markBoundary([&](ConcVLL::Transaction::id_t b){ ckpt->begin(b); });
+        ckpt->run([&q, boundary]{ q.waitForOlder(boundary); });
+        std::this_thread::sleep_for(std::chrono::seconds(cfg.duration_seconds) - half);
+    } else {
+        std::this_thread::sleep_for(std::chrono::seconds(cfg.duration_seconds));
+    }
     stop.store(true);
     req_cv.notify_all();
 
@@ -220,13 +599,24 @@ long run_vll(const BenchConfig& cfg) {
         std::lock_guard<std::mutex> lg(req_m);
         reqs.clear();
     }
-    q.CancelAll(store);
     for (auto &p : producers) p.join();
+    if (sequencer) sequencer->stop();
+    // Cancellations are not replicated, so with replicas the queue drains.
+    if (replicas.empty()) q.CancelAll(store);
 
     std::this_thread::sleep_for(200ms);
 
     monitor.join();
     for (auto &t : vll_threads) if (t.joinable()) t.join();
+    // With replicas the backlog drains instead of being cancelled, so the
+    // run lasts longer than duration_seconds.
+    double run_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+
+    if (!cfg.trace_path.empty()) {
+        ConcVLL::Tracer::disable();
+        ConcVLL::Tracer::writeChromeTrace(cfg.trace_path);
+        std::cout << vll_label << " trace written to " << cfg.trace_path << "\n";
+    }
 
     std::clock_t cpu_end = std::clock();
     double cpu_seconds = double(cpu_end - cpu_start) / double(CLOCKS_PER_SEC);
@@ -234,11 +624,119 @@ long run_vll(const BenchConfig& cfg) {
     if (committed_count > 0 && !cfg.quiet) {
         double ns_per_tx = (cpu_seconds / double(committed_count)) * 1e9;
         std::cout << vll_label << " CPU time=" << cpu_seconds << "s, per-tx=" << ns_per_tx << " ns\n";
+        print_perf(vll_label, perf_totals.total(), committed_count);
+    }
+    if (perf) *perf = perf_totals.total();
+    if (ckpt) {
+        auto info = ckpt->wait();
+        if (!cfg.quiet) {
+            std::cout << vll_label << " checkpoint: records=" << info.records << ", boundary=" << info.boundaryId
+                      << ", preserved=" << info.preserved << ", bytes=" << info.bytes
+                      << ", time=" << info.seconds << "s\n";
+        }
+    }
+
+    if (final_checksum) *final_checksum = store.checksum();
+
+    if (!replicas.empty()) {
+        primary.close();
+        uint64_t primary_sum = store.checksum();
+        auto ps = primary.stats();
+        std::cout << vll_label << " replication: transport=" << cfg.replica_transport
+                  << ", epochs=" << ps.epochs << ", bytes/replica=" << ps.bytes
+                  << ", ship_time=" << ps.shipSeconds << "s\n";
+        std::cout << vll_label << " run incl. drain=" << run_seconds << "s, "
+                  << (double(committed_count) / run_seconds) << " tps over the whole run\n";
+        for (std::size_t i = 0; i < replicas.size(); ++i) {
+            auto drain_start = std::chrono::steady_clock::now();
+            replicas[i]->wait();
+            std::chrono::duration<double> drain = std::chrono::steady_clock::now() - drain_start;
+            auto rs = replicas[i]->stats();
+            bool match = replica_stores[i]->checksum() == primary_sum;
+            std::cout << "[Replica " << i << "] epochs=" << rs.epochs << ", txns=" << rs.txns
+                      << ", lag ms: avg=" << rs.lagAvgMs << ", max=" << rs.lagMaxMs
+                      << ", catch-up=" << drain.count() << "s, state "
+                      << (match ? "matches" : "DOES NOT match") << " primary"
+                      << (rs.corrupt ? " (stream corrupt)" : "") << '\n';
+        }
+    }
+
+    if (log && !cfg.quiet) {
+        log->flush();
+        auto ls = log->stats();
+        std::cout << vll_label << " log: records=" << ls.records << ", bytes=" << ls.bytes
+                  << ", batches=" << ls.batches << ", syncs=" << ls.syncs;
+        if (ls.syncs > 0) std::cout << ", records/sync=" << (ls.records / ls.syncs);
+        std::cout << '\n';
+    }
+    if (!cfg.quiet) {
+        auto us = q.unblockStats();
+        std::cout << vll_label << " unblock: sca=" << us.sca << " (hits=" << us.scaHits
+                  << ", depth-limited=" << us.scaDepthLimited << ")"
+                  << ", scan_older=" << us.scanOlder << " (hits=" << us.scanOlderHits << ")"
+                  << ", head=" << us.head << " (hits=" << us.headHits << ")"
+                  << ", none=" << us.none << '\n';
+        auto qc = q.counters();
+        std::cout << vll_label << " queue: admitted free=" << qc.admittedFree << " blocked=" << qc.admittedBlocked
+                  << ", sca_scanned=" << qc.scaScanned
+                  << " (avg=" << (qc.scaCalls ? qc.scaScanned / qc.scaCalls : 0) << ")"
+                  << ", older_comparisons=" << qc.olderComparisons
+                  << ", mutex acquires=" << qc.lockAcquires << " contended=" << qc.lockContended
+                  << " wait_ms=" << (qc.lockWaitNs / 1000000)
+                  << ", idle sleeps=" << qc.idleSleeps << " wakeups=" << qc.idleWakeups << '\n';
+        {
+            std::lock_guard<std::mutex> lg(lat_m);
+            std::cout << vll_label << " latency us: p50=" << percentile(latencies_us, 0.50)
+                      << ", p99=" << percentile(latencies_us, 0.99)
+                      << ", max=" << percentile(latencies_us, 1.0) << '\n';
+        }
+        if (sequencer) {
+            auto ss = sequencer->stats();
+            std::cout << vll_label << " sequencer: epoch=" << epoch_us << "us, epochs=" << ss.epochs
+                      << ", txns/epoch=" << (ss.epochs ? ss.txns / ss.epochs : 0)
+                      << ", max_batch=" << ss.maxBatch << ", admitted_free=" << ss.admittedFree << '\n';
+        }
+        if (cfg.read_only_pct > 0) {
+            std::cout << vll_label << " read-only committed=" << committed_read_only.load()
+                      << (store.versioned() ? " (snapshot)" : " (queued)") << '\n';
+        }
+        if (store.versioned()) {
+            auto vs = store.versionStats();
+            std::cout << vll_label << " versions: created=" << vs.created << ", freed=" << vs.freed
+                      << ", live=" << (vs.created - vs.freed) << ", snapshots=" << vs.snapshots
+                      << " (retries=" << vs.snapshotRetries << "), gc_passes=" << vs.gcPasses << '\n';
+        }
     }
 
     return committed_count;
 }
 
+// Rebuilds a store from the checkpoint (or a fresh preload) plus
+// cfg.recover_from (or cfg.log_path). With `expected`, also checks that the
+// recovered state matches it.
+bool run_recovery(const BenchConfig& cfg, const uint64_t* expected = nullptr) {
+    const std::string& path = cfg.recover_from.empty() ? cfg.log_path : cfg.recover_from;
+    storageManager store;
+
+    ConcVLL::RecoveryOptions opts;
+    opts.startAfterId = startup(store, cfg, "[Recovery]");
+    opts.numThreads = cfg.num_threads;
+    opts.enable_sca = cfg.use_sca;
+    auto exec = [&](ConcVLL::txn_ptr t){ apply_txn(store, *t); };
+
+    auto rs = ConcVLL::ReplayCommandLog(path, store, exec, opts);
+    std::cout << "[Recovery] replayed=" << rs.replayed
+              << " skipped_aborted=" << rs.skippedAborted
+              << " time=" << rs.seconds << "s"
+              << " rate=" << (rs.seconds > 0 ? double(rs.replayed) / rs.seconds : 0.0) << " txn/s"
+              << (rs.truncatedTail ? " (torn tail ignored)" : "") << '\n';
+
+    if (!expected) return true;
+    bool match = store.checksum() == *expected;
+    std::cout << "[Recovery] state " << (match ? "matches" : "DOES NOT match") << " pre-crash state\n";
+    return match;
+}
+
 void run_sweep(BenchConfig& cfg) {
     std::vector<int> hot_keys_values = {
         10000, 5000, 2000, 1000, 500, 200, 100, 50, 20, 10, 5
@@ -252,11 +750,15 @@ void run_sweep(BenchConfig& cfg) {
     std::ofstream f_vll(csv_vll);
     std::ofstream f_vll_sca(csv_vll_sca);
 
-    f_2pl << "hot_keys,contention_index,throughput_tps,total_txns\n";
-    f_vll << "hot_keys,contention_index,throughput_tps,total_txns\n";
-    f_vll_sca << "hot_keys,contention_index,throughput_tps,total_txns\n";
+    std::string header = "hot_keys,contention_index,throughput_tps,total_txns";
+    if (cfg.perf) header += perf_csv_header();
+    f_2pl << header << "\n";
+    f_vll << header << "\n";
+    f_vll_sca << header << "\n";
+    PerfSample ps;
 
     cfg.quiet = true;
+    cfg.trace_path.clear();
 
     int total_runs = hot_keys_values.size() * 3;
     int current_run = 0;
@@ -278,27 +780,30 @@ void run_sweep(BenchConfig& cfg) {
         std::cout << "[" << ++current_run << "/" << total_runs << "] ";
         std::cout << "hot_keys=" << hot_keys << " (CI=" << ci << ") - 2PL... " << std::flush;
 
-        long txns = run_2pl(cfg);
+        long txns = run_2pl(cfg, &ps);
         double tps = static_cast<double>(txns) / cfg.duration_seconds;
-        f_2pl << hot_keys << "," << ci << "," << tps << "," << txns << "\n";
+        f_2pl << hot_keys << "," << ci << "," << tps << "," << txns
+              << (cfg.perf ? perf_csv_row(ps, txns) : "") << "\n";
         std::cout << tps << " tps\n";
 
         std::cout << "[" << ++current_run << "/" << total_runs << "] ";
         std::cout << "hot_keys=" << hot_keys << " (CI=" << ci << ") - VLL... " << std::flush;
 
         cfg.use_sca = false;
-        txns = run_vll(cfg);
+        txns = run_vll(cfg, nullptr, &ps);
         tps = static_cast<double>(txns) / cfg.duration_seconds;
-        f_vll << hot_keys << "," << ci << "," << tps << "," << txns << "\n";
+        f_vll << hot_keys << "," << ci << "," << tps << "," << txns
+              << (cfg.perf ? perf_csv_row(ps, txns) : "") << "\n";
         std::cout << tps << " tps\n";
 
         std::cout << "[" << ++current_run << "/" << total_runs << "] ";
         std::cout << "hot_keys=" << hot_keys << " (CI=" << ci << ") - VLL+SCA... " << std::flush;
 
         cfg.use_sca = true;
-        txns = run_vll(cfg);
+        txns = run_vll(cfg, nullptr, &ps);
         tps = static_cast<double>(txns) / cfg.duration_seconds;
-        f_vll_sca << hot_keys << "," << ci << "," << tps << "," << txns << "\n";
+        f_vll_sca << hot_keys << "," << ci << "," << tps << "," << txns
+                  << (cfg.perf ? perf_csv_row(ps, txns) : "") << "\n";
         std::cout << tps << " tps\n";
 
         std::cout << "\n";
@@ -320,6 +825,216 @@ void run_sweep(BenchConfig& cfg) {
     std::cout << "  python3 scripts/plot_results.py " << cfg.output_prefix << "\n";
 }
 
+// One phase of a --hybrid run: the base config with some workload fields
+// overridden, e.g. "hot_keys=2,writes_per_tx=2,work_us=0".
+struct Phase {
+    std::string spec;
+    BenchConfig cfg;
+};
+
+static std::vector<Phase> parse_phases(const BenchConfig& base) {
+    std::vector<Phase> out;
+    std::stringstream ss(base.phases);
+    std::string spec;
+    while (std::getline(ss, spec, ';')) {
+        if (spec.empty()) continue;
+        Phase ph{spec, base};
+        std::stringstream fs(spec);
+        std::string field;
+        while (std::getline(fs, field, ',')) {
+            auto eq = field.find('=');
+            std::string key = field.substr(0, eq);
+            if (eq == std::string::npos) throw std::invalid_argument("phase field without value: " + field);
+            int val = std::stoi(field.substr(eq + 1));
+            if (key == "hot_keys") ph.cfg.hot_keys = val;
+            else if (key == "reads_per_tx") ph.cfg.reads_per_tx = val;
+            else if (key == "writes_per_tx") ph.cfg.writes_per_tx = val;
+            else if (key == "work_us") ph.cfg.work_us = val;
+            else if (key == "read_only_pct") ph.cfg.read_only_pct = val;
+            else throw std::invalid_argument("unknown phase field: " + key);
+        }
+        out.push_back(std::move(ph));
+    }
+    if (out.empty()) throw std::invalid_argument("--phases is empty");
+    return out;
+}
+
+struct HybridResult {
+    std::vector<long> phase_commits;
+    ConcVLL::HybridStats stats;
+};
+
+// Runs the phases back to back, each for an equal share of the duration, on
+// one HybridEngine driven by `policy`. Commits are credited to the phase the
+// transaction was generated in.
+HybridResult run_hybrid(const BenchConfig& cfg, const std::vector<Phase>& phases,
+                        std::shared_ptr<ConcVLL::ModePolicy> policy, ConcVLL::CCMode initial) {
+    storageManager store;
+    std::string label = std::string("[Hybrid ") + policy->name() + "]";
+    const int n = static_cast<int>(phases.size());
+    const int max_inflight = cfg.max_inflight > 0 ? cfg.max_inflight : kBoundedInflight;
+
+    ConcVLL::HybridOptions ho;
+    ho.initial = initial;
+    ho.maxQueueSize = 10000;
+    ho.enableSca = cfg.use_sca;
+    ConcVLL::HybridEngine engine(store, policy, ho);
+    engine.queue().resumeAfter(startup(store, cfg, label.c_str()));
+
+    std::vector<std::atomic<long>> phase_commits(n);
+    std::atomic<long> inflight{0};
+    std::atomic<int> phase{0};
+    std::atomic<bool> stop{false};
+
+    std::deque<ConcVLL::txn_ptr> reqs;
+    std::mutex req_m;
+    std::condition_variable req_cv;
+
+    auto wall_start = std::chrono::steady_clock::now();
+    auto phase_len = std::chrono::duration<double>(cfg.duration_seconds) / n;
+    auto elapsed_s = [&]{
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    };
+
+    if (!cfg.quiet) {
+        engine.setSwitchHandler([&](ConcVLL::CCMode from, ConcVLL::CCMode to, double quiesce){
+            std::cout << label << " t=" << std::fixed << std::setprecision(2) << elapsed_s()
+                      << "s phase " << phase.load() << ": " << ConcVLL::modeName(from) << " -> "
+                      << ConcVLL::modeName(to) << " (quiesced in " << std::setprecision(3)
+                      << (quiesce * 1e3) << " ms)\n" << std::defaultfloat;
+        });
+    }
+    engine.start();
+
+    auto getNew = [&]() -> ConcVLL::txn_ptr {
+        std::unique_lock<std::mutex> lk(req_m);
+        req_cv.wait_for(lk, 50ms, [&]{ return !reqs.empty() || stop.load(); });
+        if (reqs.empty()) return nullptr;
+        auto t = reqs.front(); reqs.pop_front();
+        return t;
+    };
+
+    auto exec = [&](ConcVLL::txn_ptr t){
+        int ph = static_cast<BenchTxn&>(*t).phase;
+        apply_txn(store, *t);
+        std::this_thread::sleep_for(std::chrono::microseconds(phases[ph].cfg.work_us));
+        phase_commits[ph].fetch_add(1, std::memory_order_relaxed);
+        inflight.fetch_sub(1, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < cfg.num_threads; ++i) {
+        workers.emplace_back([&]{ engine.workerLoop(exec, getNew, [&]{ return stop.load(); }); });
+    }
+
+    auto producer = [&](int id){
+        std::mt19937_64 rng(id + 789);
+        std::uniform_int_distribution<int> pct(0, 99);
+        while (!stop.load()) {
+            if (inflight.load(std::memory_order_relaxed) >= max_inflight) {
+                std::this_thread::sleep_for(20us);
+                continue;
+            }
+            int ph = phase.load(std::memory_order_relaxed);
+            const BenchConfig& pc = phases[ph].cfg;
+            auto tx = std::make_shared<BenchTxn>();
+            tx->phase = ph;
+            if (pc.read_only_pct > 0 && pct(rng) < pc.read_only_pct) {
+                auto sets = gen_read_only_sets(pc, rng);
+                tx->assignKeys(sets.reads, sets.writes);
+            } else {
+                auto sets = gen_tx_sets(pc, rng);
+                tx->assignKeys(sets.reads, sets.writes, sets.updates);
+            }
+            inflight.fetch_add(1, std::memory_order_relaxed);
+            tx->submitted = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> lg(req_m);
+                reqs.push_back(tx);
+            }
+            req_cv.notify_one();
+        }
+    };
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < cfg.num_threads; ++i) producers.emplace_back(producer, i);
+
+    for (int ph = 0; ph < n; ++ph) {
+        phase.store(ph);
+        std::this_thread::sleep_until(wall_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(phase_len * (ph + 1)));
+    }
+    stop.store(true);
+    req_cv.notify_all();
+    for (auto &p : producers) p.join();
+    {
+        std::lock_guard<std::mutex> lg(req_m);
+        reqs.clear();
+    }
+    req_cv.notify_all();
+    for (auto &w : workers) w.join();
+    engine.stop();
+
+    HybridResult r;
+    for (auto &c : phase_commits) r.phase_commits.push_back(c.load());
+    r.stats = engine.stats();
+    return r;
+}
+
+// Fixed VLL, fixed 2PL and the probing hybrid over the same phase sequence.
+int run_hybrid_comparison(const BenchConfig& cfg) {
+    std::vector<Phase> phases;
+    try {
+        phases = parse_phases(cfg);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\nUse --help for usage information\n";
+        return 1;
+    }
+    const double phase_s = double(cfg.duration_seconds) / double(phases.size());
+
+    std::cout << "Running hybrid comparison: num_threads=" << cfg.num_threads
+              << " duration=" << cfg.duration_seconds << "s"
+              << " max_inflight=" << (cfg.max_inflight > 0 ? cfg.max_inflight : kBoundedInflight) << '\n';
+    for (std::size_t i = 0; i < phases.size(); ++i) {
+        std::cout << "  phase " << i << ": " << phases[i].spec << " (" << phase_s << "s)\n";
+    }
+
+    std::vector<std::pair<std::shared_ptr<ConcVLL::ModePolicy>, ConcVLL::CCMode>> policies = {
+        {std::make_shared<ConcVLL::FixedModePolicy>(ConcVLL::CCMode::VLL), ConcVLL::CCMode::VLL},
+        {std::make_shared<ConcVLL::FixedModePolicy>(ConcVLL::CCMode::TwoPL), ConcVLL::CCMode::TwoPL},
+        {std::make_shared<ConcVLL::ProbingModePolicy>(), ConcVLL::CCMode::VLL},
+    };
+    std::vector<HybridResult> results;
+    for (auto &pi : policies) {
+        auto &p = pi.first;
+        std::cout << "Running " << p->name() << "...\n";
+        results.push_back(run_hybrid(cfg, phases, p, pi.second));
+        const auto& st = results.back().stats;
+        std::cout << "[Hybrid " << p->name() << "] switches=" << st.switches
+                  << ", time VLL=" << st.seconds[0] << "s 2PL=" << st.seconds[1] << "s"
+                  << ", quiescence total=" << (st.quiesceSeconds * 1e3) << " ms"
+                  << " max=" << (st.maxQuiesceSeconds * 1e3) << " ms\n";
+    }
+
+    std::cout << "\nphase,vll_tps,2pl_tps,hybrid_tps,hybrid_vs_best\n";
+    long totals[3] = {};
+    long best_total = 0;
+    for (std::size_t i = 0; i < phases.size(); ++i) {
+        long c[3];
+        for (int k = 0; k < 3; ++k) {
+            c[k] = results[k].phase_commits[i];
+            totals[k] += c[k];
+        }
+        long best = std::max(c[0], c[1]);
+        best_total += best;
+        std::cout << i << ',' << long(c[0] / phase_s) << ',' << long(c[1] / phase_s) << ','
+                  << long(c[2] / phase_s) << ',' << (best ? 100.0 * double(c[2]) / double(best) : 0.0) << "%\n";
+    }
+    std::cout << "all," << (totals[0] / cfg.duration_seconds) << ',' << (totals[1] / cfg.duration_seconds) << ','
+              << (totals[2] / cfg.duration_seconds) << ','
+              << (best_total ? 100.0 * double(totals[2]) / double(best_total) : 0.0) << "%\n";
+    return 0;
+}
+
 int main(int argc, char** argv) {
     BenchConfig cfg;
 
@@ -340,6 +1055,8 @@ int main(int argc, char** argv) {
                 cfg.duration_seconds = std::stoi(val);
             } else if (key == "hot_keys") {
                 cfg.hot_keys = std::stoi(val);
+            } else if (key == "hot_updates") {
+                cfg.hot_updates = (val.empty() || val == "1" || val == "true" || val == "yes");
             } else if (key == "key_space") {
                 cfg.key_space = std::stoi(val);
             } else if (key == "reads_per_tx") {
@@ -350,6 +1067,52 @@ int main(int argc, char** argv) {
                 cfg.work_us = std::stoi(val);
             } else if (key == "use_sca") {
                 cfg.use_sca = (val == "1" || val == "true" || val == "yes");
+            } else if (key == "unblock_policy") {
+                cfg.unblock_policy = val;
+            } else if (key == "sca_blocked_ratio") {
+                cfg.sca_blocked_ratio = std::stod(val);
+            } else if (key == "sca_min_depth") {
+                cfg.sca_min_depth = std::stoi(val);
+            } else if (key == "log_path") {
+                cfg.log_path = val;
+            } else if (key == "log_sync") {
+                cfg.log_sync = val;
+            } else if (key == "group_commit_us") {
+                cfg.group_commit_us = std::stoi(val);
+            } else if (key == "verify_recovery") {
+                cfg.verify_recovery = (val.empty() || val == "1" || val == "true" || val == "yes");
+            } else if (key == "recover_from") {
+                cfg.recover_from = val;
+            } else if (key == "checkpoint_path") {
+                cfg.checkpoint_path = val;
+            } else if (key == "checkpoint_during_run") {
+                cfg.checkpoint_during_run = (val.empty() || val == "1" || val == "true" || val == "yes");
+            } else if (key == "scan_pct") {
+                cfg.scan_pct = std::stoi(val);
+            } else if (key == "scan_keys") {
+                cfg.scan_keys = std::stoi(val);
+            } else if (key == "read_only_pct") {
+                cfg.read_only_pct = std::stoi(val);
+            } else if (key == "mvcc") {
+                cfg.mvcc = (val.empty() || val == "1" || val == "true" || val == "yes");
+            } else if (key == "epoch_us") {
+                cfg.epoch_us = std::stoi(val);
+            } else if (key == "max_inflight") {
+                cfg.max_inflight = std::stoi(val);
+            } else if (key == "replicas") {
+                cfg.replicas = std::stoi(val);
+            } else if (key == "replica_transport") {
+                cfg.replica_transport = val;
+            } else if (key == "pin") {
+                cfg.pin = val;
+            } else if (key == "perf") {
+                cfg.perf = (val.empty() || val == "1" || val == "true" || val == "yes");
+            } else if (key == "trace") {
+                cfg.trace_path = val;
+            } else if (key == "hybrid") {
+                cfg.hybrid = (val.empty() || val == "1" || val == "true" || val == "yes");
+            } else if (key == "phases") {
+                cfg.phases = val;
             } else if (key == "sweep") {
                 cfg.sweep = (val.empty() || val == "1" || val == "true" || val == "yes");
             } else if (key == "output_prefix") {
@@ -363,11 +1126,41 @@ int main(int argc, char** argv) {
                 std::cout << "  --num_threads=N        Number of worker threads (default: 1)\n";
                 std::cout << "  --duration_seconds=N   Duration per benchmark (default: 5)\n";
                 std::cout << "  --hot_keys=N           Number of hot keys (default: 100)\n";
+                std::cout << "  --hot_updates=BOOL     Hot-key writes become commutative increments (default: false)\n";
                 std::cout << "  --key_space=N          Total key space size (default: 1000000)\n";
                 std::cout << "  --reads_per_tx=N       Reads per transaction (default: 0)\n";
                 std::cout << "  --writes_per_tx=N      Writes per transaction (default: 10)\n";
                 std::cout << "  --work_us=N            Simulated work microseconds (default: 160)\n";
                 std::cout << "  --use_sca=BOOL         Enable SCA for VLL (default: true)\n";
+                std::cout << "  --unblock_policy=STR   VLL unblocking policy: paper|adaptive (default: paper)\n";
+                std::cout << "  --sca_blocked_ratio=F  Adaptive: blocked fraction that triggers SCA (default: 0.25)\n";
+                std::cout << "  --sca_min_depth=N      Adaptive: SCA scan depth when hit rate is low (default: 64)\n";
+                std::cout << "  --log_path=PATH        Command-log VLL transactions to PATH and compare with in-memory\n";
+                std::cout << "  --log_sync=STR         Log sync policy: none|periodic|group (default: group)\n";
+                std::cout << "  --group_commit_us=N    Max time a log batch waits to grow (default: 200)\n";
+                std::cout << "  --verify_recovery      With --log_path: replay the log afterwards and compare state\n";
+                std::cout << "  --recover_from=PATH    Only replay a command log and report recovery time\n";
+                std::cout << "  --checkpoint_path=PATH Start VLL from this snapshot, writing it first if missing\n";
+                std::cout << "  --checkpoint_during_run  Take a copy-on-write checkpoint to --checkpoint_path mid-run\n";
+                std::cout << "  --scan_pct=N           Percent of VLL transactions that are range scans (default: 0)\n";
+                std::cout << "  --scan_keys=N          Approximate keys per range scan (default: 1000)\n";
+                std::cout << "  --read_only_pct=N      Percent of transactions that only read (default: 0)\n";
+                std::cout << "  --mvcc=BOOL            VLL: read-only transactions use snapshots, not the queue (default: true)\n";
+                std::cout << "  --epoch_us=N           VLL: admit in sequenced epochs of N us, e.g. 5000 (default: 0, off)\n";
+                std::cout << "  --max_inflight=N       VLL: max submitted but unfinished transactions (default: 0, unbounded;\n";
+                std::cout << "                         1024 with --epoch_us, --replicas or --hybrid)\n";
+                std::cout << "  --replicas=N           VLL: replicate sequenced epochs to N local replicas; implies --epoch_us=5000 if unset (default: 0)\n";
+                std::cout << "  --replica_transport=STR  Replication transport: inproc|unix (default: inproc)\n";
+                std::cout << "  --pin=STR              Pin 2PL/VLL workers and producers: none|compact|scatter (default: none)\n";
+                std::cout << "  --perf                 Per-tx cycles, instructions, LLC/branch misses and context switches\n";
+                std::cout << "                         of the worker threads (perf_event_open; also adds sweep CSV columns)\n";
+                std::cout << "  --trace=PATH           VLL: record admit/unblock/execute/finish events per thread and\n";
+                std::cout << "                         write them to PATH as Chrome trace JSON (chrome://tracing, Perfetto)\n";
+                std::cout << "  --hybrid               Run the phases below under fixed VLL, fixed 2PL and the adaptive\n";
+                std::cout << "                         hybrid that switches between them; report per-phase tps and switches\n";
+                std::cout << "  --phases=STR           Hybrid: ';'-separated phases of hot_keys, reads_per_tx, writes_per_tx,\n";
+                std::cout << "                         work_us, read_only_pct overrides, e.g. \"hot_keys=2,work_us=0;hot_keys=4\"\n";
+                std::cout << "                         (default: alternates a 100-hot-key and an 8-hot-key phase, 4 phases)\n";
                 std::cout << "  --sweep                Run contention sweep and generate graphs\n";
                 std::cout << "  --output_prefix=STR    Output file prefix for sweep (default: benchmark_results)\n";
                 std::cout << "  --quiet                Suppress per-second output\n";
@@ -381,19 +1174,37 @@ int main(int argc, char** argv) {
         }
     }
 
+    try {
+        parsePinStrategy(cfg.pin);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << "\nUse --help for usage information\n";
+        return 1;
+    }
+
     if (cfg.sweep) {
         run_sweep(cfg);
         return 0;
     }
+    if (!cfg.recover_from.empty()) {
+        run_recovery(cfg);
+        return 0;
+    }
+    if (cfg.hybrid) return run_hybrid_comparison(cfg);
     // Single run benchmark
     std::cout << "Running microbenchmark: num_threads=" << cfg.num_threads
               << " duration=" << cfg.duration_seconds << "s"
-              << " hot_keys=" << cfg.hot_keys
+              << " hot_keys=" << cfg.hot_keys << (cfg.hot_updates ? " (updates)" : "")
               << " key_space=" << cfg.key_space
               << " reads_per_tx=" << cfg.reads_per_tx
               << " writes_per_tx=" << cfg.writes_per_tx
               << " work_us=" << cfg.work_us
               << " use_sca=" << (cfg.use_sca ? "true" : "false")
+              << " unblock_policy=" << cfg.unblock_policy
+              << " read_only_pct=" << cfg.read_only_pct
+              << " mvcc=" << (cfg.mvcc ? "true" : "false")
+              << " epoch_us=" << cfg.epoch_us
+              << " replicas=" << cfg.replicas
+              << " pin=" << cfg.pin
               << std::endl;
 
     if (cfg.hot_keys > 0) {
@@ -403,10 +1214,40 @@ int main(int argc, char** argv) {
         std::cout << "Contention index: N/A (legacy hot_ratio mode)\n";
     }
 
+    if (cfg.pin != "none") {
+        CpuTopology topo = CpuTopology::detect();
+        std::cout << "Topology: " << topo.describe() << "; " << cfg.pin << " worker cpus:";
+        for (int c : placementPlan(topo, parsePinStrategy(cfg.pin), cfg.num_threads)) std::cout << ' ' << c;
+        std::cout << '\n';
+    }
+
     std::cout << "Running 2PL...\n";
     auto c2 = run_2pl(cfg);
     std::cout << "2PL committed txns: " << c2 << " (" << (c2 / cfg.duration_seconds) << " tps)\n";
 
+    if (!cfg.log_path.empty()) {
+        BenchConfig mem_cfg = cfg;
+        mem_cfg.log_path.clear();
+        mem_cfg.checkpoint_during_run = false;
+        mem_cfg.trace_path.clear();
+        std::cout << "Running VLL" << (cfg.use_sca ? " with SCA" : " without SCA") << " (in-memory baseline)...\n";
+        auto cm = run_vll(mem_cfg);
+        std::cout << "VLL" << (cfg.use_sca ? "+SCA" : "") << " in-memory committed txns: " << cm << " (" << (cm / cfg.duration_seconds) << " tps)\n";
+
+        std::cout << "Running VLL" << (cfg.use_sca ? " with SCA" : " without SCA") << " (command log, sync=" << cfg.log_sync << ")...\n";
+        uint64_t pre_crash = 0;
+        auto cl = run_vll(cfg, &pre_crash);
+        std::cout << "VLL" << (cfg.use_sca ? "+SCA" : "") << " logged committed txns: " << cl << " (" << (cl / cfg.duration_seconds) << " tps)\n";
+        if (cm > 0) {
+            std::cout << "Durability overhead: " << (100.0 * double(cm - cl) / double(cm)) << "%\n";
+        }
+        if (cfg.verify_recovery) {
+            std::cout << "Replaying command log...\n";
+            if (!run_recovery(cfg, &pre_crash)) return 1;
+        }
+        return 0;
+    }
+
     std::cout << "Running VLL" << (cfg.use_sca ? " with SCA" : " without SCA") << "...\n";
     auto cv = run_vll(cfg);
     std::cout << "VLL" << (cfg.use_sca ? "+SCA" : "") << " committed txns: " << cv << " (" << (cv / cfg.duration_seconds) << " tps)\n";
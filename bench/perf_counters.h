@@ -0,0 +1,129 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <ctime>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Hardware and scheduler counters for the calling thread via
+// perf_event_open. Events the kernel refuses (no PMU in a VM,
+// perf_event_paranoid too strict) are simply marked unavailable; the
+// thread's CPU time is always collected.
+
+enum PerfEvent { kCycles = 0, kInstructions, kLLCMisses, kBranchMisses, kContextSwitches, kPerfEvents };
+
+struct PerfSample {
+    std::array<uint64_t, kPerfEvents> value{};
+    std::array<bool, kPerfEvents> valid{};
+    uint64_t cpuNs = 0;
+    int threads = 0;
+
+    void add(const PerfSample& o) {
+        for (int i = 0; i < kPerfEvents; ++i) {
+            // An event counts only if every contributing thread had it.
+            valid[i] = (threads == 0 || valid[i]) && o.valid[i];
+            value[i] += o.value[i];
+        }
+        cpuNs += o.cpuNs;
+        threads += o.threads;
+    }
+
+    bool any() const {
+        for (bool v : valid) if (v) return true;
+        return false;
+    }
+};
+
+class ThreadPerfCounters {
+public:
+    // Opens and starts the counters for the calling thread.
+    ThreadPerfCounters() {
+        static const struct { uint32_t type; uint64_t config; } events[kPerfEvents] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+        };
+        for (int i = 0; i < kPerfEvents; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[i].type;
+            attr.config = events[i].config;
+            attr.disabled = 1;
+            // Unprivileged users may only count user space; context
+            // switches are only seen from the kernel side.
+            attr.exclude_kernel = events[i].type == PERF_TYPE_HARDWARE;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds_[i] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+        }
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+        cpuStart_ = threadCpuNs();
+    }
+
+    ~ThreadPerfCounters() {
+        for (int fd : fds_) if (fd >= 0) ::close(fd);
+    }
+
+    ThreadPerfCounters(const ThreadPerfCounters&) = delete;
+    ThreadPerfCounters& operator=(const ThreadPerfCounters&) = delete;
+
+    // Counts since construction, scaled up if the PMU was multiplexed.
+    PerfSample read() const {
+        PerfSample s;
+        s.threads = 1;
+        s.cpuNs = threadCpuNs() - cpuStart_;
+        for (int i = 0; i < kPerfEvents; ++i) {
+            if (fds_[i] < 0) continue;
+            uint64_t buf[3];
+            if (::read(fds_[i], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)) || buf[2] == 0) continue;
+            s.value[i] = buf[2] < buf[1] ? static_cast<uint64_t>(double(buf[0]) * double(buf[1]) / double(buf[2]))
+                                         : buf[0];
+            s.valid[i] = true;
+        }
+        return s;
+    }
+
+private:
+    static uint64_t threadCpuNs() {
+        timespec ts;
+        ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    int fds_[kPerfEvents];
+    uint64_t cpuStart_;
+};
+
+// Sums the samples of several threads.
+class PerfTotals {
+public:
+    void add(const PerfSample& s) {
+        std::lock_guard<std::mutex> lg(m_);
+        total_.add(s);
+    }
+
+    PerfSample total() const {
+        std::lock_guard<std::mutex> lg(m_);
+        return total_;
+    }
+
+private:
+    mutable std::mutex m_;
+    PerfSample total_;
+};
+
+#endif
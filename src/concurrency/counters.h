@@ -0,0 +1,67 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ConcVLL {
+
+// Shard of the calling thread, fixed at its first counter update.
+inline std::size_t counterShard() {
+    static std::atomic<std::size_t> next{0};
+    thread_local std::size_t shard = next.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+// Event counters for hot paths. Each thread adds to its own cache line, so
+// updates never contend unless more than kShards threads are counting;
+// reads sum every shard and are only approximately simultaneous. Enum must
+// end with a kCount enumerator.
+template <class Enum>
+class PerThreadCounters {
+public:
+    static constexpr std::size_t kCounters = static_cast<std::size_t>(Enum::kCount);
+    static constexpr std::size_t kShards = 64;
+
+    PerThreadCounters() { reset(); }
+
+    PerThreadCounters(const PerThreadCounters&) = delete;
+    PerThreadCounters& operator=(const PerThreadCounters&) = delete;
+
+    void add(Enum c, uint64_t n = 1) {
+        shards_[counterShard() % kShards].v[static_cast<std::size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t read(Enum c) const {
+        uint64_t sum = 0;
+        for (const auto& s : shards_) sum += s.v[static_cast<std::size_t>(c)].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    std::array<uint64_t, kCounters> snapshot() const {
+        std::array<uint64_t, kCounters> out{};
+        for (const auto& s : shards_) {
+            for (std::size_t i = 0; i < kCounters; ++i) out[i] += s.v[i].load(std::memory_order_relaxed);
+        }
+        return out;
+    }
+
+    void reset() {
+        for (auto& s : shards_) {
+            for (auto& v : s.v) v.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> v[kCounters];
+    };
+
+    Shard shards_[kShards];
+};
+
+}
+
+#endif
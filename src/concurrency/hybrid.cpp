@@ -0,0 +1,253 @@
+#include "hybrid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ConcVLL {
+
+namespace {
+
+CCMode other(CCMode m) { return m == CCMode::VLL ? CCMode::TwoPL : CCMode::VLL; }
+
+double since_s(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+}
+
+const char* modeName(CCMode m) {
+    return m == CCMode::VLL ? "VLL" : "2PL";
+}
+
+CCMode ProbingModePolicy::decide(const ModeWindow& w) {
+    Seen& cur = seen_[static_cast<int>(w.mode)];
+    Seen& oth = seen_[static_cast<int>(other(w.mode))];
+    ++dwell_;
+    ++oth.age;
+
+    // The first window after a switch starts from an empty queue or lock
+    // table, so it says little about the mode.
+    if (dwell_ == 1) return w.mode;
+    if (dwell_ == 2) {
+        cur.throughput = w.throughput();
+        entryContention_ = w.contention;
+    } else {
+        cur.throughput = 0.5 * cur.throughput + 0.5 * w.throughput();
+    }
+    cur.valid = true;
+    cur.age = 0;
+    if (dwell_ < cfg_.minWindows) return w.mode;
+
+    bool stale = !oth.valid || oth.age >= cfg_.reprobeWindows;
+    if (std::fabs(w.contention - entryContention_) > cfg_.contentionShift) {
+        // The workload changed: only this window describes it.
+        cur.throughput = w.throughput();
+        stale = true;
+    }
+    bool faster = oth.valid && oth.throughput > cur.throughput * (1.0 + cfg_.margin);
+    if (!stale && !faster) return w.mode;
+    dwell_ = 0;
+    return other(w.mode);
+}
+
+HybridEngine::HybridEngine(::storageManager& store, std::shared_ptr<ModePolicy> policy, HybridOptions opts)
+    : store_(store), policy_(std::move(policy)), opts_(opts), mode_(opts.initial) {}
+
+HybridEngine::~HybridEngine() {
+    stop();
+}
+
+void HybridEngine::start() {
+    if (controller_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lg(m_);
+        stop_ = false;
+    }
+    nextId_.store(queue_.markBoundary(nullptr) + 1, std::memory_order_relaxed);
+    controller_ = std::thread([this]{ controllerMain(); });
+}
+
+void HybridEngine::stop() {
+    {
+        std::lock_guard<std::mutex> lg(m_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (controller_.joinable()) controller_.join();
+}
+
+void HybridEngine::setSwitchHandler(std::function<void(CCMode, CCMode, double)> fn) {
+    onSwitch_ = std::move(fn);
+}
+
+HybridStats HybridEngine::stats() const {
+    std::lock_guard<std::mutex> lg(m_);
+    return stats_;
+}
+
+void HybridEngine::workerLoop(std::function<void(txn_ptr)> execute,
+                              std::function<txn_ptr()> getNewTxnRequest,
+                              std::function<bool()> shouldStop) {
+    while (true) {
+        CCMode m;
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            cv_.wait(lk, [this]{ return !switching_.load(std::memory_order_relaxed); });
+            m = mode_.load(std::memory_order_relaxed);
+            ++running_;
+        }
+        bool done = m == CCMode::VLL ? runVLL(execute, getNewTxnRequest, shouldStop)
+                                     : run2PL(execute, getNewTxnRequest, shouldStop);
+        {
+            std::lock_guard<std::mutex> lg(m_);
+            --running_;
+        }
+        cv_.notify_all();
+        if (done) return;
+    }
+}
+
+bool HybridEngine::runVLL(const std::function<void(txn_ptr)>& execute,
+                          const std::function<txn_ptr()>& getNewTxnRequest,
+                          const std::function<bool()>& shouldStop) {
+    // VLLMainLoop only returns once no request is handed out, its stop
+    // predicate holds and the queue is empty, which is exactly the drain a
+    // switch needs.
+    bool stopped = false;
+    queue_.VLLMainLoop(store_,
+        [&](txn_ptr T){
+            execute(T);
+            commits_.fetch_add(1, std::memory_order_relaxed);
+        },
+        [&]() -> txn_ptr {
+            if (switching_.load(std::memory_order_acquire)) return nullptr;
+            return getNewTxnRequest();
+        },
+        [&]{
+            if (switching_.load(std::memory_order_acquire)) return true;
+            stopped = shouldStop && shouldStop();
+            return stopped;
+        },
+        opts_.maxQueueSize, opts_.enableSca);
+    return stopped;
+}
+
+bool HybridEngine::run2PL(const std::function<void(txn_ptr)>& execute,
+                          const std::function<txn_ptr()>& getNewTxnRequest,
+                          const std::function<bool()>& shouldStop) {
+    while (!switching_.load(std::memory_order_acquire)) {
+        txn_ptr T = getNewTxnRequest();
+        if (!T) {
+            if (shouldStop && shouldStop()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        runLocked(T, execute);
+    }
+    return false;
+}
+
+void HybridEngine::runLocked(const txn_ptr& T, const std::function<void(txn_ptr)>& execute) {
+    if (T->id == 0) T->id = nextId_.fetch_add(1, std::memory_order_relaxed);
+
+    const std::vector<KeyHandle>* reads = &T->ReadSet;
+    std::vector<KeyHandle> withRanges;
+    if (!T->ReadRanges.empty()) {
+        withRanges = T->ReadSet;
+        T->RangeKeys.clear();
+        for (const auto& r : T->ReadRanges) {
+            store_.rangeQuery(r.lo, r.hi, [&](std::string_view key, tuple&){
+                T->RangeKeys.push_back(key);
+                if (std::find(T->WriteSet.begin(), T->WriteSet.end(), key) == T->WriteSet.end())
+                    withRanges.emplace_back(key);
+                return true;
+            });
+        }
+        reads = &withRanges;
+    }
+
+    locks_.acquire_all_atomically(*reads, T->WriteSet, T->UpdateSet);
+    execute(T);
+    if (store_.versioned()) store_.publishVersions(T->WriteSet);
+    locks_.release_all(*reads, T->WriteSet, T->UpdateSet);
+    T->status = TxnStatus::Committed;
+    commits_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::pair<uint64_t, uint64_t> HybridEngine::contentionCounters(CCMode m) const {
+    if (m == CCMode::VLL) {
+        QueueCounters c = queue_.counters();
+        return {c.admittedFree + c.admittedBlocked, c.admittedBlocked};
+    }
+    LockManagerCounters c = locks_.counters();
+    return {c.acquires, c.waits};
+}
+
+void HybridEngine::controllerMain() {
+    using clock = std::chrono::steady_clock;
+    CCMode m = mode_.load(std::memory_order_relaxed);
+    auto windowStart = clock::now();
+    uint64_t commits0 = commits_.load(std::memory_order_relaxed);
+    auto c0 = contentionCounters(m);
+
+    std::unique_lock<std::mutex> lk(m_);
+    while (!stop_) {
+        cv_.wait_for(lk, opts_.window, [this]{ return stop_; });
+        if (stop_) break;
+
+        ModeWindow w;
+        w.mode = m;
+        w.seconds = since_s(windowStart);
+        uint64_t commits1 = commits_.load(std::memory_order_relaxed);
+        w.commits = commits1 - commits0;
+        auto c1 = contentionCounters(m);
+        uint64_t events = c1.first - c0.first;
+        w.contention = events ? double(c1.second - c0.second) / double(events) : 0.0;
+        stats_.commits[static_cast<int>(m)] += w.commits;
+        stats_.seconds[static_cast<int>(m)] += w.seconds;
+
+        lk.unlock();
+        CCMode next = policy_->decide(w);
+        if (next != m) {
+            switchTo(next);
+            // Transactions that finished while the old mode drained.
+            lk.lock();
+            stats_.commits[static_cast<int>(m)] += commits_.load(std::memory_order_relaxed) - commits1;
+            lk.unlock();
+            m = next;
+        }
+        windowStart = clock::now();
+        commits0 = commits_.load(std::memory_order_relaxed);
+        c0 = contentionCounters(m);
+        lk.lock();
+    }
+}
+
+void HybridEngine::switchTo(CCMode next) {
+    auto t0 = std::chrono::steady_clock::now();
+    CCMode from;
+    double secs;
+    {
+        std::unique_lock<std::mutex> lk(m_);
+        from = mode_.load(std::memory_order_relaxed);
+        switching_.store(true, std::memory_order_release);
+        cv_.wait(lk, [this]{ return running_ == 0; });
+
+        // Nothing runs now; carry the id sequence over to the next mode.
+        if (from == CCMode::VLL) {
+            nextId_.store(queue_.markBoundary(nullptr) + 1, std::memory_order_relaxed);
+        } else {
+            queue_.resumeAfter(nextId_.load(std::memory_order_relaxed) - 1);
+        }
+        mode_.store(next, std::memory_order_release);
+        switching_.store(false, std::memory_order_release);
+
+        secs = since_s(t0);
+        ++stats_.switches;
+        stats_.quiesceSeconds += secs;
+        if (secs > stats_.maxQuiesceSeconds) stats_.maxQuiesceSeconds = secs;
+    }
+    cv_.notify_all();
+    if (onSwitch_) onSwitch_(from, next, secs);
+}
+
+}
@@ -0,0 +1,184 @@
+#ifndef HYBRID_H
+#define HYBRID_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "vll.h"
+#include "lock_manager_2pl.h"
+
+namespace ConcVLL {
+
+enum class CCMode : uint8_t { VLL = 0, TwoPL };
+
+const char* modeName(CCMode m);
+
+// What the running mode did during one measurement window. Contention is
+// the fraction of transactions admitted blocked under VLL, and the fraction
+// of lock acquisitions that had to wait under 2PL.
+struct ModeWindow {
+    CCMode mode = CCMode::VLL;
+    double seconds = 0.0;
+    uint64_t commits = 0;
+    double contention = 0.0;
+
+    double throughput() const { return seconds > 0 ? double(commits) / seconds : 0.0; }
+};
+
+// Chooses the mode for the next window. Called on the engine's controller
+// thread only, so implementations may keep state.
+class ModePolicy {
+public:
+    virtual ~ModePolicy() = default;
+
+    virtual CCMode decide(const ModeWindow& w) = 0;
+
+    virtual const char* name() const = 0;
+};
+
+class FixedModePolicy : public ModePolicy {
+public:
+    explicit FixedModePolicy(CCMode m) : mode_(m) {}
+
+    CCMode decide(const ModeWindow&) override { return mode_; }
+
+    const char* name() const override { return mode_ == CCMode::VLL ? "vll" : "2pl"; }
+
+private:
+    CCMode mode_;
+};
+
+// Runs whichever mode was measured faster. The two contention figures are
+// not comparable with each other, but a shift in the running mode's own
+// contention means the workload changed and the other mode's throughput is
+// stale, so it is measured again; it is also re-measured periodically.
+class ProbingModePolicy : public ModePolicy {
+public:
+    struct Config {
+        int minWindows = 3;             // windows a mode runs before it may be left
+        int reprobeWindows = 100;       // re-measure the other mode at least this often
+        double contentionShift = 0.15;  // change that invalidates the other mode's throughput
+        double margin = 0.05;           // the other mode must be this much faster to switch
+    };
+
+    ProbingModePolicy() = default;
+    explicit ProbingModePolicy(const Config& cfg) : cfg_(cfg) {}
+
+    CCMode decide(const ModeWindow& w) override;
+
+    const char* name() const override { return "probing"; }
+
+private:
+    struct Seen {
+        bool valid = false;
+        double throughput = 0.0;
+        int age = 0;                    // windows since it was last measured
+    };
+
+    Config cfg_;
+    Seen seen_[2];
+    int dwell_ = 0;                     // windows since the last switch
+    double entryContention_ = 0.0;      // running mode's contention when it was entered
+};
+
+struct HybridOptions {
+    std::chrono::milliseconds window{100};
+    CCMode initial = CCMode::VLL;
+    std::size_t maxQueueSize = 1024;    // VLL mode, as for VLLMainLoop
+    bool enableSca = true;
+};
+
+struct HybridStats {
+    uint64_t switches = 0;
+    uint64_t commits[2] = {};           // by CCMode
+    double seconds[2] = {};             // time spent running each mode
+    double quiesceSeconds = 0.0;        // total time with no mode running
+    double maxQuiesceSeconds = 0.0;
+};
+
+// Runs a store under VLL (a TxnQueue) or 2PL (a LockManager2PL) and
+// switches between them as the policy asks. A switch quiesces the running
+// mode: workers stop taking new requests, under VLL the queue drains
+// through VLLMainLoop's own stop rule, and under 2PL every worker finishes
+// the transaction it holds. Only then does the other mode start, so no
+// transaction ever runs alongside one from the other protocol. Transaction
+// ids continue across switches.
+//
+// The whole store switches as one: transactions span arbitrary keys, so a
+// per-partition mode would need cross-protocol locking on every key the
+// partitions share. Range scans under 2PL lock the keys in range at the
+// time they start, as VLL does at admission. The queue must not have a
+// command log, since 2PL transactions are not logged.
+class HybridEngine {
+public:
+    HybridEngine(::storageManager& store, std::shared_ptr<ModePolicy> policy, HybridOptions opts = {});
+    ~HybridEngine();
+
+    HybridEngine(const HybridEngine&) = delete;
+    HybridEngine& operator=(const HybridEngine&) = delete;
+
+    // For setUnblockPolicy or resumeAfter before start().
+    TxnQueue& queue() { return queue_; }
+
+    // Starts the controller thread that measures windows and switches.
+    void start();
+    void stop();
+
+    // Run by every worker thread, with the same contract as
+    // TxnQueue::VLLMainLoop. Returns once shouldStop() is true and the
+    // running mode has nothing left.
+    void workerLoop(std::function<void(txn_ptr)> execute,
+                    std::function<txn_ptr()> getNewTxnRequest,
+                    std::function<bool()> shouldStop);
+
+    CCMode mode() const { return mode_.load(std::memory_order_acquire); }
+
+    HybridStats stats() const;
+
+    // Called on the controller thread after each switch with the time the
+    // quiescence took. Must be set before start().
+    void setSwitchHandler(std::function<void(CCMode from, CCMode to, double quiesceSeconds)> fn);
+
+private:
+    bool runVLL(const std::function<void(txn_ptr)>& execute,
+                const std::function<txn_ptr()>& getNewTxnRequest,
+                const std::function<bool()>& shouldStop);
+    bool run2PL(const std::function<void(txn_ptr)>& execute,
+                const std::function<txn_ptr()>& getNewTxnRequest,
+                const std::function<bool()>& shouldStop);
+    void runLocked(const txn_ptr& T, const std::function<void(txn_ptr)>& execute);
+
+    void controllerMain();
+    // Contention counters of the running mode, for windowing.
+    std::pair<uint64_t, uint64_t> contentionCounters(CCMode m) const;
+    void switchTo(CCMode next);
+
+    ::storageManager& store_;
+    std::shared_ptr<ModePolicy> policy_;
+    HybridOptions opts_;
+
+    TxnQueue queue_;
+    LockManager2PL locks_;
+    std::atomic<Transaction::id_t> nextId_{1};   // 2PL mode
+    std::atomic<uint64_t> commits_{0};
+
+    std::atomic<CCMode> mode_;
+    std::atomic<bool> switching_{false};
+    mutable std::mutex m_;
+    std::condition_variable cv_;
+    int running_ = 0;               // workers inside a mode
+    HybridStats stats_;
+
+    std::function<void(CCMode, CCMode, double)> onSwitch_;
+    bool stop_ = false;
+    std::thread controller_;
+};
+
+}
+
+#endif
@@ -1,124 +1,101 @@
 #include "lock_manager_2pl.h"
+#include <chrono>
 #include <vector>
 #include <thread>
 
-void LockManager2PL::acquire(const std::string& key, LockMode mode) {
-    auto& head = get_lock_head(key);
-    std::unique_lock<std::mutex> lk(head.mtx);
+namespace {
 
-    auto req = std::make_shared<LockRequest>();
-    req->mode = mode;
-    req->owner = std::this_thread::get_id();
-
-    head.queue.push_back(req);
-
-    while (!can_grant(head, req)) {
-        req->cv.wait(lk);
-    }
-    req->granted = true;
-
-    if (mode == LockMode::Shared) {
-        head.shared_count++;
-        head.current_mode = LockMode::Shared;
-    } else {
-        head.exclusive = true;
-        head.current_mode = LockMode::Exclusive;
-    }
+bool has_updaters(const LockHead& h) {
+    for (int c : h.update_count) if (c > 0) return true;
+    return false;
 }
 
-void LockManager2PL::release(const std::string& key, LockMode mode) {
-    auto& head = get_lock_head(key);
-    std::unique_lock<std::mutex> lk(head.mtx);
-
-    for (auto it = head.queue.begin(); it != head.queue.end(); ++it) {
-        auto& req = *it;
-        if (req->owner == std::this_thread::get_id() && req->mode == mode && req->granted) {
-            if (mode == LockMode::Shared) {
-                head.shared_count--;
-            } else {
-                head.exclusive = false;
-            }
-            head.queue.erase(it);
-            break;
-        }
-    }
-
-    for (auto& next : head.queue) {
-        if (!next->granted && can_grant(head, next)) {
-            next->cv.notify_one();
-        }
-    }
+uint64_t since_ns(std::chrono::steady_clock::time_point t0) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count());
 }
 
-LockHead& LockManager2PL::get_lock_head(const std::string& key) {
-    std::lock_guard<std::mutex> lg(map_mtx_);
-    return locks_[key];
 }
 
-bool LockManager2PL::can_grant(const LockHead& head, const std::shared_ptr<LockRequest>& req) {
-    if (req->mode == LockMode::Shared) {
+LockHead& LockManager2PL::lock_head_locked(const KeyHandle& key) {
+    auto it = locks_.find(key);
+    if (it != locks_.end()) return it->second;
+    keys_.emplace_back(key.key);
+    return locks_[KeyHandle(keys_.back(), key.hash)];
+}
 
-        for (const auto& r : head.queue) {
-            if (r == req) break;
-            if (r->mode == LockMode::Exclusive && !r->granted) return false;
-        }
-        return !head.exclusive;
-    } else {
+void LockManager2PL::acquire_all_atomically(const std::vector<KeyHandle>& reads,
+                                            const std::vector<KeyHandle>& writes,
+                                            const std::vector<CommutativeUpdate>& updates) {
+    std::unique_lock<std::mutex> lk(global_mtx_);
+    counters_.add(LockCounter::Acquires);
 
-        return head.queue.front() == req && head.shared_count == 0 && !head.exclusive;
+    // Heads are found once; map nodes never move, and their lock state is
+    // only touched under global_mtx_.
+    std::vector<LockHead*> heads;
+    heads.reserve(writes.size() + reads.size() + updates.size());
+    {
+        std::lock_guard<std::mutex> map_lk(map_mtx_);
+        for (const auto& k : writes) heads.push_back(&lock_head_locked(k));
+        for (const auto& k : reads)  heads.push_back(&lock_head_locked(k));
+        for (const auto& u : updates) heads.push_back(&lock_head_locked(u.key));
     }
-}
+    const std::size_t nw = writes.size();
+    const std::size_t nr = nw + reads.size();
 
-void LockManager2PL::acquire_all_atomically(const std::vector<std::string>& reads,
-                                            const std::vector<std::string>& writes) {
-    std::unique_lock<std::mutex> lk(global_mtx_);
+    bool waited = false;
+    std::chrono::steady_clock::time_point t0;
     while (true) {
         bool ok = true;
-        {
-
-            std::lock_guard<std::mutex> map_lk(map_mtx_);
-            for (const auto& k : writes) (void)locks_[k];
-            for (const auto& k : reads)  (void)locks_[k];
+        for (std::size_t i = 0; i < nw; ++i) {
+            const auto& h = *heads[i];
+            if (h.exclusive || h.shared_count > 0 || has_updaters(h)) { ok = false; break; }
         }
-
-        {
-            std::lock_guard<std::mutex> map_lk(map_mtx_);
-            for (const auto& k : writes) {
-                const auto it = locks_.find(k);
-                const auto& h = it->second;
-                if (h.exclusive || h.shared_count > 0) { ok = false; break; }
+        if (ok) {
+            for (std::size_t i = nw; i < nr; ++i) {
+                if (heads[i]->exclusive || has_updaters(*heads[i])) { ok = false; break; }
             }
-            if (ok) {
-                for (const auto& k : reads) {
-                    const auto it = locks_.find(k);
-                    const auto& h = it->second;
-                    if (h.exclusive) { ok = false; break; }
-                }
+        }
+        for (std::size_t i = nr; ok && i < heads.size(); ++i) {
+            const auto& h = *heads[i];
+            const int op = static_cast<int>(updates[i - nr].op);
+            if (h.exclusive || h.shared_count > 0) { ok = false; break; }
+            for (int o = 0; o < kUpdateOps; ++o) {
+                if (o != op && h.update_count[o] > 0) { ok = false; break; }
             }
         }
 
         if (ok) {
-
-            std::lock_guard<std::mutex> map_lk(map_mtx_);
-            for (const auto& k : writes) {
-                auto& h = locks_[k];
-                h.exclusive = true;
-                h.current_mode = LockMode::Exclusive;
+            for (std::size_t i = 0; i < nw; ++i) {
+                heads[i]->exclusive = true;
+                heads[i]->current_mode = LockMode::Exclusive;
             }
-            for (const auto& k : reads) {
-                auto& h = locks_[k];
-                h.shared_count++;
-                h.current_mode = LockMode::Shared;
+            for (std::size_t i = nw; i < nr; ++i) {
+                heads[i]->shared_count++;
+                heads[i]->current_mode = LockMode::Shared;
             }
+            for (std::size_t i = nr; i < heads.size(); ++i) {
+                heads[i]->update_count[static_cast<int>(updates[i - nr].op)]++;
+            }
+            if (waited) counters_.add(LockCounter::WaitNs, since_ns(t0));
             return;
         }
 
+        if (waited) {
+            counters_.add(LockCounter::FutileWakeups);
+        } else {
+            waited = true;
+            counters_.add(LockCounter::Waits);
+            t0 = std::chrono::steady_clock::now();
+        }
         global_cv_.wait(lk);
+        counters_.add(LockCounter::Wakeups);
     }
 }
 
-void LockManager2PL::release_all(const std::vector<std::string>& reads,
-                                 const std::vector<std::string>& writes) {
+void LockManager2PL::release_all(const std::vector<KeyHandle>& reads,
+                                 const std::vector<KeyHandle>& writes,
+                                 const std::vector<CommutativeUpdate>& updates) {
     {
         std::lock_guard<std::mutex> lk(global_mtx_);
         std::lock_guard<std::mutex> map_lk(map_mtx_);
@@ -135,6 +112,29 @@ void LockManager2PL::release_all(const std::vector<std::string>& reads,
                 if (it->second.shared_count > 0) it->second.shared_count--;
             }
         }
+        for (const auto& u : updates) {
+            auto it = locks_.find(u.key);
+            if (it != locks_.end()) {
+                int& c = it->second.update_count[static_cast<int>(u.op)];
+                if (c > 0) c--;
+            }
+        }
     }
+    // Every waiter wakes to recheck its whole key set; Wakeups against
+    // Notifies shows the size of the herd.
     global_cv_.notify_all();
+    counters_.add(LockCounter::Notifies);
+}
+
+LockManagerCounters LockManager2PL::counters() const {
+    auto c = counters_.snapshot();
+    auto at = [&c](LockCounter k){ return c[static_cast<std::size_t>(k)]; };
+    LockManagerCounters s;
+    s.acquires = at(LockCounter::Acquires);
+    s.waits = at(LockCounter::Waits);
+    s.waitNs = at(LockCounter::WaitNs);
+    s.notifies = at(LockCounter::Notifies);
+    s.wakeups = at(LockCounter::Wakeups);
+    s.futileWakeups = at(LockCounter::FutileWakeups);
+    return s;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <deque>
 #include <unordered_map>
 #include <list>
 #include <mutex>
@@ -8,24 +9,55 @@
 #include <condition_variable>
 #include <vector>
 #include "../core/record.h"
+#include "../core/key_handle.h"
+#include "counters.h"
 
+enum class LockCounter : uint8_t {
+    Acquires = 0,
+    Waits,
+    WaitNs,
+    Notifies,
+    Wakeups,
+    FutileWakeups,
+    kCount
+};
+
+struct LockManagerCounters {
+    uint64_t acquires = 0;
+    uint64_t waits = 0;          // acquisitions that blocked at least once
+    uint64_t waitNs = 0;
+    uint64_t notifies = 0;       // notify calls on release
+    uint64_t wakeups = 0;
+    uint64_t futileWakeups = 0;  // woke up and went back to waiting
+};
+
+// Locks a transaction's whole key set at once. There is no single-key
+// acquire: every grant decision is made under one mutex against the shared,
+// exclusive and update counts of all the keys involved.
 class LockManager2PL {
 public:
-    void acquire(const std::string& key, LockMode mode);
-    void release(const std::string& key, LockMode mode);
+    // Update locks are compatible with each other when their operations
+    // match, and conflict with shared and exclusive locks.
+    void acquire_all_atomically(const std::vector<KeyHandle>& reads,
+                                const std::vector<KeyHandle>& writes,
+                                const std::vector<CommutativeUpdate>& updates = {});
+    void release_all(const std::vector<KeyHandle>& reads,
+                     const std::vector<KeyHandle>& writes,
+                     const std::vector<CommutativeUpdate>& updates = {});
 
-    void acquire_all_atomically(const std::vector<std::string>& reads,
-                                const std::vector<std::string>& writes);
-    void release_all(const std::vector<std::string>& reads,
-                     const std::vector<std::string>& writes);
+    LockManagerCounters counters() const;
 
 private:
-    std::unordered_map<std::string, LockHead> locks_;
+    // Keys are views into keys_, so a lookup by KeyHandle never rehashes
+    // or copies the key.
+    std::unordered_map<KeyHandle, LockHead, KeyHandleHash> locks_;
+    std::deque<std::string> keys_;
     std::mutex map_mtx_;
 
     std::mutex global_mtx_;
     std::condition_variable global_cv_;
 
-    LockHead& get_lock_head(const std::string& key);
-    bool can_grant(const LockHead& head, const std::shared_ptr<LockRequest>& req);
+    LockHead& lock_head_locked(const KeyHandle& key);
+
+    ConcVLL::PerThreadCounters<LockCounter> counters_;
 };
\ No newline at end of file
@@ -1,29 +1,48 @@
 #include "sca.h"
 #include "../transaction/transaction.h"
 #include <functional>
+#include <string_view>
 
 namespace ConcVLL {
 
 constexpr size_t SCA_BITSET_SIZE = 819200;
 
-txn_ptr SCA::analyze(std::deque<txn_ptr>& queue) {
+txn_ptr SCA::analyze(std::deque<txn_ptr>& queue, std::size_t maxDepth, std::size_t* examined) {
     
     std::vector<bool> Dx(SCA_BITSET_SIZE, false);  
     std::vector<bool> Ds(SCA_BITSET_SIZE, false);  
-    std::hash<std::string> hasher;
+    // Commutative updates: one bit per UpdateOp, since only updates with
+    // the same operation are compatible.
+    std::vector<uint8_t> Dc(SCA_BITSET_SIZE, 0);
+    // Keys created after an older scan was admitted are not in its
+    // RangeKeys, so writers are also checked against the ranges themselves.
+    std::vector<const KeyRange*> olderRanges;
+    std::size_t scanned = 0;
+    if (examined) *examined = 0;
 
     for (const auto& T : queue) {
+        if (maxDepth && scanned >= maxDepth) break;
+        ++scanned;
+        if (examined) *examined = scanned;
         
         if (!T->hashes_cached) {
             T->hashedReadSet.clear();
-            T->hashedReadSet.reserve(T->ReadSet.size());
+            T->hashedReadSet.reserve(T->ReadSet.size() + T->RangeKeys.size());
             for (const auto& key : T->ReadSet) {
-                T->hashedReadSet.push_back(hasher(key) % SCA_BITSET_SIZE);
+                T->hashedReadSet.push_back(key.hash % SCA_BITSET_SIZE);
+            }
+            for (const auto& key : T->RangeKeys) {
+                T->hashedReadSet.push_back(hashKey(key) % SCA_BITSET_SIZE);
             }
             T->hashedWriteSet.clear();
             T->hashedWriteSet.reserve(T->WriteSet.size());
             for (const auto& key : T->WriteSet) {
-                T->hashedWriteSet.push_back(hasher(key) % SCA_BITSET_SIZE);
+                T->hashedWriteSet.push_back(key.hash % SCA_BITSET_SIZE);
+            }
+            T->hashedUpdateSet.clear();
+            T->hashedUpdateSet.reserve(T->UpdateSet.size());
+            for (const auto& u : T->UpdateSet) {
+                T->hashedUpdateSet.push_back(u.key.hash % SCA_BITSET_SIZE);
             }
             T->hashes_cached = true;
         }
@@ -32,7 +51,7 @@ txn_ptr SCA::analyze(std::deque<txn_ptr>& queue) {
             bool success = true;
             
             for (const auto& hash_val : T->hashedReadSet) {
-                if (Dx[hash_val]) {
+                if (Dx[hash_val] || Dc[hash_val]) {
                     success = false;
                     break;
                 }
@@ -40,7 +59,28 @@ txn_ptr SCA::analyze(std::deque<txn_ptr>& queue) {
 
             if (success) {
                 for (const auto& hash_val : T->hashedWriteSet) {
-                    if (Dx[hash_val] || Ds[hash_val]) {
+                    if (Dx[hash_val] || Ds[hash_val] || Dc[hash_val]) {
+                        success = false;
+                        break;
+                    }
+                }
+            }
+
+            for (std::size_t i = 0; success && i < T->UpdateSet.size(); ++i) {
+                std::size_t hash_val = T->hashedUpdateSet[i];
+                uint8_t mine = uint8_t(1u << static_cast<int>(T->UpdateSet[i].op));
+                if (Dx[hash_val] || Ds[hash_val] || (Dc[hash_val] & ~mine)) success = false;
+            }
+
+            for (std::size_t i = 0; success && i < olderRanges.size(); ++i) {
+                for (const auto& key : T->WriteSet) {
+                    if (olderRanges[i]->contains(key.key)) {
+                        success = false;
+                        break;
+                    }
+                }
+                for (const auto& u : T->UpdateSet) {
+                    if (olderRanges[i]->contains(u.key.key)) {
                         success = false;
                         break;
                     }
@@ -60,6 +100,12 @@ txn_ptr SCA::analyze(std::deque<txn_ptr>& queue) {
         for (const auto& hash_val : T->hashedWriteSet) {
             Dx[hash_val] = true;
         }
+        for (std::size_t i = 0; i < T->UpdateSet.size(); ++i) {
+            Dc[T->hashedUpdateSet[i]] |= uint8_t(1u << static_cast<int>(T->UpdateSet[i].op));
+        }
+        for (const auto& r : T->ReadRanges) {
+            olderRanges.push_back(&r);
+        }
     }
 
     return nullptr;
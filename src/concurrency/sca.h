@@ -13,7 +13,10 @@ using txn_ptr = std::shared_ptr<Transaction>;
 class SCA {
 public:
 
-    static txn_ptr analyze(std::deque<txn_ptr>& queue);
+    // Examines at most maxDepth entries from the front; 0 scans the whole
+    // queue. If given, *examined is set to the number of entries looked at.
+    static txn_ptr analyze(std::deque<txn_ptr>& queue, std::size_t maxDepth = 0,
+                           std::size_t* examined = nullptr);
 };
 
 }
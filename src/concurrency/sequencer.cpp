@@ -0,0 +1,96 @@
+#include "sequencer.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace ConcVLL {
+
+Sequencer::Sequencer(TxnQueue& queue, ::storageManager& store, SequencerOptions opts)
+    : queue_(queue), store_(store), opts_(opts) {}
+
+Sequencer::~Sequencer() {
+    stop();
+}
+
+void Sequencer::start() {
+    if (thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lg(m_);
+        stop_ = false;
+    }
+    thread_ = std::thread([this]{
+        Tracer::nameThread("sequencer");
+        run();
+    });
+}
+
+void Sequencer::stop() {
+    {
+        std::lock_guard<std::mutex> lg(m_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    roomCv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void Sequencer::submit(txn_ptr T) {
+    if (!T) return;
+    std::unique_lock<std::mutex> lk(m_);
+    if (opts_.maxQueueSize) {
+        roomCv_.wait(lk, [this]{ return stop_ || pending_.size() < opts_.maxQueueSize; });
+    }
+    pending_.push_back(std::move(T));
+}
+
+void Sequencer::setBatchHandler(std::function<void(uint64_t, const std::vector<txn_ptr>&)> fn) {
+    onBatch_ = std::move(fn);
+}
+
+SequencerStats Sequencer::stats() const {
+    std::lock_guard<std::mutex> lg(m_);
+    return stats_;
+}
+
+void Sequencer::run() {
+    auto next = std::chrono::steady_clock::now() + opts_.epoch;
+    std::unique_lock<std::mutex> lk(m_);
+    while (true) {
+        cv_.wait_until(lk, next, [this]{ return stop_; });
+        bool stopping = stop_;
+        // Epoch boundaries stay on a fixed grid even when admitting a batch
+        // overruns one; missed boundaries are skipped, not queued up.
+        auto now = std::chrono::steady_clock::now();
+        while (next <= now) next += opts_.epoch;
+
+        batch_.swap(pending_);
+        roomCv_.notify_all();
+        lk.unlock();
+        sealEpoch();
+        lk.lock();
+        if (stopping) break;
+    }
+}
+
+void Sequencer::sealEpoch() {
+    if (batch_.empty()) return;
+    // Holding the epoch back also holds back the submitters behind it, so a
+    // backlog cannot build up in the queue where it only adds latency.
+    if (opts_.maxQueueSize) {
+        queue_.waitForRoom(opts_.maxQueueSize, [this]{
+            std::lock_guard<std::mutex> lg(m_);
+            return stop_;
+        });
+    }
+    std::size_t admittedFree = queue_.BeginBatch(batch_, store_);
+    ++epoch_;
+    if (onBatch_) onBatch_(epoch_, batch_);
+
+    std::lock_guard<std::mutex> lg(m_);
+    ++stats_.epochs;
+    stats_.txns += batch_.size();
+    stats_.maxBatch = std::max<uint64_t>(stats_.maxBatch, batch_.size());
+    stats_.admittedFree += admittedFree;
+    batch_.clear();
+}
+
+}
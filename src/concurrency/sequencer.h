@@ -0,0 +1,86 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "vll.h"
+
+namespace ConcVLL {
+
+struct SequencerOptions {
+    // How long submissions accumulate before the epoch is sealed.
+    std::chrono::microseconds epoch{5000};
+    // Backpressure: an epoch is not admitted while the queue holds this many
+    // transactions, and submit() blocks while this many wait for the next
+    // epoch. 0 means unbounded.
+    std::size_t maxQueueSize = 10000;
+};
+
+struct SequencerStats {
+    uint64_t epochs = 0;        // non-empty epochs handed to the queue
+    uint64_t txns = 0;
+    uint64_t maxBatch = 0;
+    uint64_t admittedFree = 0;
+};
+
+// Calvin-style sequencing stage in front of a TxnQueue. Producers submit
+// from any thread; a sequencer thread seals the submissions of each epoch
+// in arrival order and admits them with TxnQueue::BeginBatch, which assigns
+// ids in that order. The epoch is therefore the unit of ordering, logging
+// and (later) replication, and the queue mutex is taken once per epoch
+// rather than once per transaction.
+//
+// Workers run VLLMainLoop as usual with a getNewTxnRequest that returns
+// null; they pick batch transactions off the queue's ready list.
+class Sequencer {
+public:
+    Sequencer(TxnQueue& queue, ::storageManager& store, SequencerOptions opts = {});
+    ~Sequencer();
+
+    Sequencer(const Sequencer&) = delete;
+    Sequencer& operator=(const Sequencer&) = delete;
+
+    void start();
+    // Seals and admits whatever is pending, then joins the sequencer thread.
+    void stop();
+
+    // Blocks while maxQueueSize submissions are already pending.
+    void submit(txn_ptr T);
+
+    // Called on the sequencer thread with each non-empty epoch (numbered
+    // from 1) right after it is admitted, so ids are set. Epochs arrive in
+    // order; the next one is not admitted until the handler returns. Must
+    // be set before start().
+    void setBatchHandler(std::function<void(uint64_t, const std::vector<txn_ptr>&)> fn);
+
+    SequencerStats stats() const;
+
+private:
+    void run();
+    void sealEpoch();
+
+    TxnQueue& queue_;
+    ::storageManager& store_;
+    SequencerOptions opts_;
+
+    mutable std::mutex m_;
+    std::condition_variable cv_;
+    std::condition_variable roomCv_;    // submitters waiting for pending_ to drain
+    std::vector<txn_ptr> pending_;
+    bool stop_ = false;
+    SequencerStats stats_;
+
+    std::function<void(uint64_t, const std::vector<txn_ptr>&)> onBatch_;
+    std::vector<txn_ptr> batch_;    // sequencer thread only
+    uint64_t epoch_ = 0;            // sequencer thread only
+    std::thread thread_;
+};
+
+}
+
+#endif
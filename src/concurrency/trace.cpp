@@ -0,0 +1,240 @@
+#include "trace.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ConcVLL {
+
+std::atomic<bool> Tracer::on_{false};
+
+namespace {
+
+uint64_t steadyNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return steadyNs();
+#endif
+}
+
+struct Record {
+    uint64_t ts;
+    uint64_t txn : 48;
+    uint64_t event : 8;
+    uint64_t arg : 8;
+};
+
+// Written only by its owning thread; next is published with release so a
+// dump sees complete records.
+struct Ring {
+    Ring(std::size_t capacity, int tid, uint64_t generation, std::string name)
+        : slots(capacity), mask(capacity - 1), tid(tid), generation(generation), name(std::move(name)) {}
+
+    std::vector<Record> slots;
+    std::size_t mask;
+    std::atomic<uint64_t> next{0};
+    int tid;
+    uint64_t generation;
+    std::string name;
+};
+
+// Rings from earlier enable() calls are retired rather than freed, since a
+// thread may still be writing to one.
+struct Registry {
+    std::mutex m;
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::atomic<uint64_t> generation{0};
+    std::size_t capacity = 1 << 16;
+    uint64_t startTicks = 0;
+    uint64_t startNs = 0;
+    int nextTid = 0;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+thread_local Ring* tlsRing = nullptr;
+thread_local std::string tlsName;
+
+Ring* attach() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.m);
+    std::string name = tlsName.empty() ? "thread " + std::to_string(reg.nextTid) : tlsName;
+    reg.rings.push_back(std::make_unique<Ring>(reg.capacity, reg.nextTid++,
+                                               reg.generation.load(std::memory_order_relaxed), std::move(name)));
+    return reg.rings.back().get();
+}
+
+std::string escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+const char* causeName(uint8_t cause) {
+    switch (static_cast<UnblockCause>(cause)) {
+    case UnblockCause::ScanOlder: return "scan_older";
+    case UnblockCause::Sca: return "sca";
+    case UnblockCause::Head: return "head";
+    case UnblockCause::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+}
+
+void Tracer::enable(std::size_t capacity) {
+    Registry& reg = registry();
+    {
+        std::lock_guard<std::mutex> lg(reg.m);
+        std::size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        reg.capacity = cap;
+        reg.startTicks = ticks();
+        reg.startNs = steadyNs();
+        reg.generation.fetch_add(1, std::memory_order_relaxed);
+    }
+    on_.store(true, std::memory_order_release);
+}
+
+void Tracer::disable() {
+    on_.store(false, std::memory_order_release);
+}
+
+void Tracer::record(TraceEvent e, uint64_t txn, uint8_t arg) {
+    Ring* r = tlsRing;
+    if (r == nullptr || r->generation != registry().generation.load(std::memory_order_relaxed))
+        r = tlsRing = attach();
+    uint64_t i = r->next.load(std::memory_order_relaxed);
+    Record& rec = r->slots[i & r->mask];
+    rec.ts = ticks();
+    rec.txn = txn;
+    rec.event = static_cast<uint8_t>(e);
+    rec.arg = arg;
+    r->next.store(i + 1, std::memory_order_release);
+}
+
+void Tracer::nameThread(const std::string& name) {
+    tlsName = name;
+    if (tlsRing) {
+        std::lock_guard<std::mutex> lg(registry().m);
+        tlsRing->name = name;
+    }
+}
+
+void Tracer::writeChromeTrace(const std::string& path) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.m);
+
+    uint64_t gen = reg.generation.load(std::memory_order_relaxed);
+    double elapsedNs = double(steadyNs() - reg.startNs);
+    double ticksPerUs = elapsedNs > 0 ? double(ticks() - reg.startTicks) * 1000.0 / elapsedNs : 1000.0;
+    if (ticksPerUs <= 0) ticksPerUs = 1000.0;
+
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) throw std::system_error(errno, std::generic_category(), "open " + path);
+
+    bool first = true;
+    auto sep = [&]{
+        std::fputs(first ? "\n" : ",\n", f);
+        first = false;
+    };
+
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f);
+    for (const auto& r : reg.rings) {
+        if (r->generation != gen) continue;
+        sep();
+        std::fprintf(f, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     r->tid, escape(r->name).c_str());
+
+        uint64_t end = r->next.load(std::memory_order_acquire);
+        uint64_t begin = end > r->slots.size() ? end - r->slots.size() : 0;
+        // Older records may have been overwritten, so drop ends whose begin
+        // is gone.
+        int execDepth = 0, idleDepth = 0;
+        for (uint64_t i = begin; i < end; ++i) {
+            const Record& rec = r->slots[i & r->mask];
+            double ts = double(rec.ts - reg.startTicks) / ticksPerUs;
+            unsigned long long txn = rec.txn;
+            switch (static_cast<TraceEvent>(rec.event)) {
+            case TraceEvent::Admit:
+                sep();
+                std::fprintf(f, "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"admit\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                             "\"args\":{\"txn\":%llu,\"blocked\":%s}}",
+                             r->tid, ts, txn, rec.arg ? "true" : "false");
+                if (rec.arg) {
+                    sep();
+                    std::fprintf(f, "{\"ph\":\"b\",\"cat\":\"txn\",\"name\":\"blocked\",\"id\":%llu,\"pid\":1,"
+                                 "\"tid\":%d,\"ts\":%.3f}", txn, r->tid, ts);
+                }
+                break;
+            case TraceEvent::Unblock:
+                sep();
+                std::fprintf(f, "{\"ph\":\"e\",\"cat\":\"txn\",\"name\":\"blocked\",\"id\":%llu,\"pid\":1,"
+                             "\"tid\":%d,\"ts\":%.3f,\"args\":{\"cause\":\"%s\"}}",
+                             txn, r->tid, ts, causeName(static_cast<uint8_t>(rec.arg)));
+                break;
+            case TraceEvent::ExecBegin:
+                ++execDepth;
+                sep();
+                std::fprintf(f, "{\"ph\":\"B\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                             "\"args\":{\"txn\":%llu}}",
+                             rec.arg ? "snapshot" : "execute", r->tid, ts, txn);
+                break;
+            case TraceEvent::ExecEnd:
+                if (execDepth == 0) break;
+                --execDepth;
+                sep();
+                std::fprintf(f, "{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", r->tid, ts);
+                break;
+            case TraceEvent::Finish:
+                sep();
+                std::fprintf(f, "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                             "\"args\":{\"txn\":%llu}}",
+                             rec.arg ? "cancel" : "finish", r->tid, ts, txn);
+                break;
+            case TraceEvent::IdleBegin:
+                ++idleDepth;
+                sep();
+                std::fprintf(f, "{\"ph\":\"B\",\"name\":\"idle\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", r->tid, ts);
+                break;
+            case TraceEvent::IdleEnd:
+                if (idleDepth == 0) break;
+                --idleDepth;
+                sep();
+                std::fprintf(f, "{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", r->tid, ts);
+                break;
+            }
+        }
+    }
+    std::fputs("\n]}\n", f);
+
+    bool failed = std::ferror(f) != 0;
+    int err = errno;
+    if (std::fclose(f) != 0 && !failed) {
+        failed = true;
+        err = errno;
+    }
+    if (failed) throw std::system_error(err, std::generic_category(), "write " + path);
+}
+
+}
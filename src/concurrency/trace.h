@@ -0,0 +1,57 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ConcVLL {
+
+enum class TraceEvent : uint8_t {
+    Admit = 0,      // arg: 1 if admitted blocked
+    Unblock,        // arg: UnblockCause
+    ExecBegin,      // arg: 1 for a snapshot read
+    ExecEnd,
+    Finish,         // arg: 1 if cancelled
+    IdleBegin,      // worker found nothing to do
+    IdleEnd
+};
+
+enum class UnblockCause : uint8_t { ScanOlder = 0, Sca, Head, Cancelled };
+
+// Transaction lifecycle tracer. Each thread appends to its own ring buffer
+// (oldest records are overwritten), so recording takes no locks; when
+// tracing is off a record is a single relaxed load. Timestamps are TSC
+// ticks on x86 and steady-clock nanoseconds elsewhere, converted when the
+// trace is written.
+class Tracer {
+public:
+    // Starts recording into fresh rings of `capacity` records per thread.
+    static void enable(std::size_t capacity = 1 << 16);
+    static void disable();
+    static bool on() { return on_.load(std::memory_order_relaxed); }
+
+    static void record(TraceEvent e, uint64_t txn, uint8_t arg = 0);
+
+    // Label for the calling thread's track in the dump.
+    static void nameThread(const std::string& name);
+
+    // Writes everything still in the rings as Chrome trace event JSON
+    // (chrome://tracing, Perfetto). Call with tracing off or with the
+    // recording threads quiescent. Throws std::system_error on I/O errors.
+    static void writeChromeTrace(const std::string& path);
+
+private:
+    static std::atomic<bool> on_;
+};
+
+// Records only while tracing is on; arguments are not evaluated otherwise.
+#define VLL_TRACE(...)                                                       \
+    do {                                                                     \
+        if (::ConcVLL::Tracer::on()) ::ConcVLL::Tracer::record(__VA_ARGS__); \
+    } while (0)
+
+}
+
+#endif
@@ -0,0 +1,32 @@
+#include "unblock_policy.h"
+#include <algorithm>
+
+namespace ConcVLL {
+
+UnblockDecision QueueFullPolicy::decide(const UnblockMetrics& m) const {
+    if (m.queueSize == 0) return {};
+    if (!m.full()) return {UnblockAction::ScanOlder, 0};
+    return {enable_sca_ ? UnblockAction::SCA : UnblockAction::Head, 0};
+}
+
+UnblockDecision AdaptivePolicy::decide(const UnblockMetrics& m) const {
+    if (m.queueSize == 0 || m.blockedCount == 0) return {};
+
+    if (m.blockedRatio() >= cfg_.blockedRatio || (m.full() && m.idleWorkers > 0)) {
+        // Scan deep while SCA keeps finding work or workers have nothing else
+        // to do; fall back to a short prefix when it has mostly been missing.
+        double weight = std::max(m.scaHitRate, m.idleRatio());
+        std::size_t minDepth = std::min(cfg_.minScanDepth, m.queueSize);
+        std::size_t depth = minDepth + static_cast<std::size_t>(
+            static_cast<double>(m.queueSize - minDepth) * weight);
+        return {UnblockAction::SCA, depth >= m.queueSize ? 0 : depth};
+    }
+
+    // The pairwise scan is quadratic in its depth, so on long queues only
+    // the front is examined. It still covers the head, and unlike Head it
+    // also reaches blocked txns a few places behind it.
+    std::size_t depth = m.queueSize <= cfg_.olderScanLimit ? 0 : cfg_.olderScanLimit;
+    return {UnblockAction::ScanOlder, depth};
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef UNBLOCK_POLICY_H
+#define UNBLOCK_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ConcVLL {
+
+// Live TxnQueue state handed to the policy on every scheduling step.
+struct UnblockMetrics {
+    std::size_t queueSize = 0;
+    std::size_t maxQueueSize = 0;
+    std::size_t blockedCount = 0;
+    std::size_t workers = 0;
+    std::size_t idleWorkers = 0;
+    double scaHitRate = 1.0;    // moving average of SCA calls that found a runnable txn
+
+    double blockedRatio() const {
+        return queueSize ? static_cast<double>(blockedCount) / static_cast<double>(queueSize) : 0.0;
+    }
+    double idleRatio() const {
+        return workers ? static_cast<double>(idleWorkers) / static_cast<double>(workers) : 0.0;
+    }
+    bool full() const { return queueSize >= maxQueueSize; }
+};
+
+enum class UnblockAction : uint8_t {
+    None = 0,   // nothing worth unblocking, go fetch new work
+    ScanOlder,  // pairwise conflictsWithOlder scan
+    SCA,        // Selective Contention Analysis
+    Head        // only release a blocked txn at the front of the queue
+};
+
+struct UnblockDecision {
+    UnblockAction action = UnblockAction::None;
+    std::size_t scanDepth = 0;  // max queue entries to examine, 0 = whole queue
+};
+
+// Policy decisions and their outcomes, read through TxnQueue::unblockStats().
+struct UnblockStats {
+    uint64_t none = 0;
+    uint64_t scanOlder = 0;
+    uint64_t sca = 0;
+    uint64_t head = 0;
+
+    uint64_t scanOlderHits = 0;
+    uint64_t scaHits = 0;
+    uint64_t headHits = 0;
+    uint64_t scaDepthLimited = 0;   // SCA calls restricted to a queue prefix
+};
+
+class UnblockPolicy {
+public:
+    virtual ~UnblockPolicy() = default;
+
+    virtual UnblockDecision decide(const UnblockMetrics& m) const = 0;
+
+    virtual const char* name() const = 0;
+};
+
+// Paper Section 2.5: SCA only when the TxnQueue is full, pairwise scan below
+// that, and head-only when the queue is full with SCA disabled.
+class QueueFullPolicy : public UnblockPolicy {
+public:
+    explicit QueueFullPolicy(bool enable_sca = true) : enable_sca_(enable_sca) {}
+
+    UnblockDecision decide(const UnblockMetrics& m) const override;
+
+    const char* name() const override { return enable_sca_ ? "paper" : "paper-nosca"; }
+
+private:
+    bool enable_sca_;
+};
+
+// Runs SCA once the blocked fraction crosses a threshold (or workers are idle
+// on a full queue) and scales the scan depth by the recent SCA hit rate.
+// Below the threshold it scans for runnable blocked txns with
+// conflictsWithOlder, over at most olderScanLimit entries.
+class AdaptivePolicy : public UnblockPolicy {
+public:
+    struct Config {
+        double blockedRatio = 0.25;       // blocked/queued fraction that triggers SCA
+        std::size_t minScanDepth = 64;    // SCA depth when it has been missing
+        std::size_t olderScanLimit = 32;  // conflictsWithOlder scan depth below the ratio
+    };
+
+    AdaptivePolicy() = default;
+    explicit AdaptivePolicy(const Config& cfg) : cfg_(cfg) {}
+
+    UnblockDecision decide(const UnblockMetrics& m) const override;
+
+    const char* name() const override { return "adaptive"; }
+
+private:
+    Config cfg_;
+};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "vll.h"
 #include "../transaction/transaction.h"
 #include "sca.h"
+#include "trace.h"
 
 #include <algorithm>
 #include <thread>
@@ -19,68 +20,128 @@ txn_ptr TxnQueue::beginTransaction() {
         std::lock_guard<std::mutex> lg(mtx_);
 
         queue_.push_back(txn);
+        if (txn->type == Transaction::Type::Blocked) ++blocked_;
     }
     return txn;
 }
 
-void TxnQueue::BeginTransaction(const txn_ptr& T, storageManager& store) {
-    if (!T) return;
+bool TxnQueue::BeginTransaction(const txn_ptr& T, storageManager& store) {
+    if (!T) return false;
+
+    // Admission is serialized so that id order, counter acquisition order,
+    // queue order and command log order all agree.
+    auto lk = lockQueue();
+    return admitLocked(T, store);
+}
+
+std::size_t TxnQueue::BeginBatch(const std::vector<txn_ptr>& batch, ::storageManager& store) {
+    std::size_t admittedFree = 0;
+    {
+        auto lk = lockQueue();
+        for (const auto &T : batch) {
+            if (T && admitLocked(T, store)) {
+                ready_.push_back(T);
+                ++admittedFree;
+            }
+        }
+    }
+    if (admittedFree) readyCv_.notify_all();
+    return admittedFree;
+}
 
+void TxnQueue::waitForRoom(std::size_t maxQueueSize, const std::function<bool()>& shouldStop) const {
+    std::unique_lock<std::mutex> lk(mtx_);
+    while (queue_.size() >= maxQueueSize) {
+        if (shouldStop && shouldStop()) return;
+        ++roomWaiters_;
+        // Timed, so shouldStop is polled even if nothing finishes.
+        roomCv_.wait_for(lk, std::chrono::milliseconds(1));
+        --roomWaiters_;
+    }
+}
+
+bool TxnQueue::admitLocked(const txn_ptr& T, ::storageManager& store) {
     if (T->id == 0) {
         T->id = nextId_.fetch_add(1, std::memory_order_relaxed);
     }
 
     T->type = decltype(T->type)::Free;
+    T->ReadRecords.clear();
+    T->WriteRecords.clear();
+    T->UpdateRecords.clear();
+    T->ReadRecords.reserve(T->ReadSet.size());
+    T->WriteRecords.reserve(T->WriteSet.size());
+    T->UpdateRecords.reserve(T->UpdateSet.size());
 
     for (const auto &key : T->ReadSet) {
-        tuple* t = store.get(key);
-        if (!t) {
-
-            store.insert(key, std::string());
-            t = store.get(key);
-        }
-
+        tuple* t = lookupOrCreateLocked(key, store);
+        T->ReadRecords.push_back(t);
         t->Cs.fetch_add(1, std::memory_order_relaxed);
-        if (t->Cx.load(std::memory_order_relaxed) > 0) {
+        if (t->Cx.load(std::memory_order_relaxed) > 0 || t->updaters() > 0) {
             T->type = decltype(T->type)::Blocked;
         }
     }
 
     for (const auto &key : T->WriteSet) {
-        tuple* t = store.get(key);
-        if (!t) {
-            store.insert(key, std::string());
-            t = store.get(key);
-        }
+        tuple* t = lookupOrCreateLocked(key, store);
+        T->WriteRecords.push_back(t);
         t->Cx.fetch_add(1, std::memory_order_relaxed);
-        if (t->Cx.load(std::memory_order_relaxed) > 1 || t->Cs.load(std::memory_order_relaxed) > 0) {
+        if (t->Cx.load(std::memory_order_relaxed) > 1 || t->Cs.load(std::memory_order_relaxed) > 0 ||
+            t->updaters() > 0) {
             T->type = decltype(T->type)::Blocked;
         }
     }
 
-    {
-        std::lock_guard<std::mutex> lg(mtx_);
-        queue_.push_back(T);
+    // Commutative updates only wait for readers, writers and updates with
+    // a different operation.
+    for (const auto &u : T->UpdateSet) {
+        tuple* t = lookupOrCreateLocked(u.key, store);
+        T->UpdateRecords.push_back(t);
+        t->Cc[static_cast<int>(u.op)].fetch_add(1, std::memory_order_relaxed);
+        if (t->Cx.load(std::memory_order_relaxed) > 0 || t->Cs.load(std::memory_order_relaxed) > 0 ||
+            t->updatersOtherThan(u.op)) {
+            T->type = decltype(T->type)::Blocked;
+        }
+    }
+
+    if (!T->ReadRanges.empty()) acquireRangesLocked(*T, store);
+
+    if (log_) T->lsn = log_->append(*T);
+    if (T->id > lastAdmittedId_) lastAdmittedId_ = T->id;
+
+    queue_.push_back(T);
+    if (T->type == Transaction::Type::Blocked) {
+        ++blocked_;
+        counters_.add(QueueCounter::AdmittedBlocked);
+        VLL_TRACE(TraceEvent::Admit, T->id, 1);
+        return false;
     }
+    counters_.add(QueueCounter::AdmittedFree);
+    VLL_TRACE(TraceEvent::Admit, T->id, 0);
+    return true;
 }
 
 void TxnQueue::FinishTransaction(const txn_ptr& T, ::storageManager& store) {
     if (!T) return;
 
-    for (const auto &key : T->ReadSet) {
-        tuple* t = store.get(key);
-        if (t) t->Cs.fetch_sub(1, std::memory_order_relaxed);
-    }
+    // Still holding Cx, so versions of a key are published in commit order.
+    store.publishVersions(T->WriteRecords);
 
-    for (const auto &key : T->WriteSet) {
-        tuple* t = store.get(key);
-        if (t) t->Cx.fetch_sub(1, std::memory_order_relaxed);
+    if (!T->ReadRanges.empty()) {
+        auto lk = lockQueue();
+        releaseRangesLocked(*T, store);
     }
 
+    releaseRecords(*T);
+
     {
-        std::lock_guard<std::mutex> lg(mtx_);
+        auto lk = lockQueue();
         auto it = std::find_if(queue_.begin(), queue_.end(), [&](const txn_ptr& x){ return x->id == T->id; });
-        if (it != queue_.end()) queue_.erase(it);
+        if (it != queue_.end()) {
+            if ((*it)->type == Transaction::Type::Blocked) --blocked_;
+            queue_.erase(it);
+        }
+        if (roomWaiters_) roomCv_.notify_all();
     }
 }
 
@@ -88,7 +149,10 @@ void TxnQueue::finishTransaction(const txn_ptr& txn) {
     if (!txn) return;
     std::lock_guard<std::mutex> lg(mtx_);
     auto it = std::find_if(queue_.begin(), queue_.end(), [&](const txn_ptr& t){ return t->id == txn->id; });
-    if (it != queue_.end()) queue_.erase(it);
+    if (it != queue_.end()) {
+        if ((*it)->type == Transaction::Type::Blocked) --blocked_;
+        queue_.erase(it);
+    }
 }
 
 std::size_t TxnQueue::activeCount() const {
@@ -97,127 +161,433 @@ std::size_t TxnQueue::activeCount() const {
 }
 
 void TxnQueue::CancelAll(::storageManager& store) {
-    std::lock_guard<std::mutex> lg(mtx_);
+    std::deque<txn_ptr> cancelled;
+    std::unique_lock<std::mutex> lk(mtx_);
+    // Free transactions in the queue are already executing; they release
+    // their own counters in FinishTransaction.
+    std::deque<txn_ptr> running;
     for (auto &T : queue_) {
         if (!T) continue;
-
-        for (const auto &key : T->ReadSet) {
-            tuple* t = store.get(key);
-            if (t) t->Cs.fetch_sub(1, std::memory_order_relaxed);
+        if (T->type == Transaction::Type::Free) {
+            running.push_back(T);
+            continue;
         }
+        cancelled.push_back(T);
+        VLL_TRACE(TraceEvent::Unblock, T->id, static_cast<uint8_t>(UnblockCause::Cancelled));
+        VLL_TRACE(TraceEvent::Finish, T->id, 1);
 
-        for (const auto &key : T->WriteSet) {
-            tuple* t = store.get(key);
-            if (t) t->Cx.fetch_sub(1, std::memory_order_relaxed);
-        }
+        T->status = TxnStatus::Aborted;
+        if (log_) log_->appendAbort(T->id);
+
+        releaseRecords(*T);
+        if (!T->ReadRanges.empty()) releaseRangesLocked(*T, store);
+    }
+    queue_.swap(running);
+    blocked_ = 0;
+    if (roomWaiters_) roomCv_.notify_all();
+    lk.unlock();
+
+    if (onComplete_) {
+        for (auto &T : cancelled) onComplete_(T);
+    }
+}
+
+// Drops the counters taken at admission, through the records it looked up.
+void TxnQueue::releaseRecords(const Transaction& T) {
+    for (tuple* t : T.ReadRecords) t->Cs.fetch_sub(1, std::memory_order_relaxed);
+    for (tuple* t : T.WriteRecords) t->Cx.fetch_sub(1, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < T.UpdateRecords.size(); ++i) {
+        T.UpdateRecords[i]->Cc[static_cast<int>(T.UpdateSet[i].op)].fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// A scan holds a shared lock on every key in its ranges except the keys it
+// writes itself, which it already holds exclusively.
+static bool writesKey(const Transaction& T, std::string_view key) {
+    return std::find(T.WriteSet.begin(), T.WriteSet.end(), key) != T.WriteSet.end();
+}
+
+tuple* TxnQueue::lookupOrCreateLocked(const KeyHandle& key, ::storageManager& store) {
+    tuple* t = store.get(key);
+    if (t) return t;
+
+    store.insert(key, std::string());
+    t = store.get(key);
+    // A key created inside a range that an older scan holds inherits that
+    // scan's shared lock, so the scan cannot miss it (no phantoms).
+    for (const auto &r : activeRanges_) {
+        if (r.second->contains(key.key)) t->Cs.fetch_add(1, std::memory_order_relaxed);
+    }
+    return t;
+}
+
+void TxnQueue::acquireRangesLocked(Transaction& T, ::storageManager& store) {
+    T.RangeKeys.clear();
+    for (const auto &r : T.ReadRanges) {
+        store.rangeQuery(r.lo, r.hi, [&](std::string_view key, tuple& t){
+            T.RangeKeys.push_back(key);
+            if (writesKey(T, key)) return true;
+            t.Cs.fetch_add(1, std::memory_order_relaxed);
+            if (t.Cx.load(std::memory_order_relaxed) > 0 || t.updaters() > 0) T.type = Transaction::Type::Blocked;
+            return true;
+        });
+        activeRanges_.emplace_back(T.id, &r);
     }
-    queue_.clear();
 }
 
-static inline bool intersects_sorted(const std::vector<std::string>& a,
-                                     const std::vector<std::string>& b) {
+// Releases every key now in T's ranges: the ones present at admission and
+// the ones created since, which inherited T's lock.
+void TxnQueue::releaseRangesLocked(const Transaction& T, ::storageManager& store) {
+    activeRanges_.erase(std::remove_if(activeRanges_.begin(), activeRanges_.end(),
+                                       [&](const auto& r){ return r.first == T.id; }),
+                        activeRanges_.end());
+    for (const auto &r : T.ReadRanges) {
+        store.rangeQuery(r.lo, r.hi, [&](std::string_view key, tuple& t){
+            if (!writesKey(T, key)) t.Cs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        });
+    }
+}
+
+static inline const KeyHandle& keyOf(const KeyHandle& k) { return k; }
+static inline const KeyHandle& keyOf(const CommutativeUpdate& u) { return u.key; }
+
+template <class A, class B>
+static inline bool intersects_sorted(const std::vector<A>& a, const std::vector<B>& b) {
+    std::size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (keyOf(a[i]) == keyOf(b[j])) return true;
+        if (keyOf(a[i]) < keyOf(b[j])) ++i; else ++j;
+    }
+    return false;
+}
+
+// Updates of one key conflict only if their operations differ.
+static bool updatesConflict(const std::vector<CommutativeUpdate>& a, const std::vector<CommutativeUpdate>& b) {
     std::size_t i = 0, j = 0;
     while (i < a.size() && j < b.size()) {
-        if (a[i] == b[j]) return true;
-        if (a[i] < b[j]) ++i; else ++j;
+        if (a[i].key == b[j].key) {
+            if (a[i].op != b[j].op) return true;
+            ++i;
+            ++j;
+        } else if (a[i].key < b[j].key) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return false;
+}
+
+// True if a writes or updates a key inside one of b's ranges.
+static bool rangeConflict(const Transaction& a, const Transaction& b) {
+    for (const auto &r : b.ReadRanges) {
+        for (const auto &w : a.WriteSet) {
+            if (r.contains(w.key)) return true;
+        }
+        for (const auto &u : a.UpdateSet) {
+            if (r.contains(u.key.key)) return true;
+        }
     }
     return false;
 }
 
-static bool conflictsWithOlder(const std::deque<ConcVLL::txn_ptr>& q, std::size_t idx) {
+static void executeTraced(const std::function<void(txn_ptr)>& execute, const txn_ptr& T, bool snapshot = false) {
+    VLL_TRACE(TraceEvent::ExecBegin, T->id, snapshot);
+    execute(T);
+    VLL_TRACE(TraceEvent::ExecEnd, T->id);
+}
+
+static bool conflictsWithOlder(const std::deque<ConcVLL::txn_ptr>& q, std::size_t idx, std::size_t& compared) {
     const auto &t = q[idx];
     for (std::size_t i = 0; i < idx; ++i) {
         const auto &older = q[i];
+        ++compared;
 
         if (intersects_sorted(t->WriteSet, older->WriteSet)) return true;
         if (intersects_sorted(t->WriteSet, older->ReadSet)) return true;
         if (intersects_sorted(t->ReadSet,  older->WriteSet)) return true;
+        if (intersects_sorted(t->UpdateSet, older->WriteSet)) return true;
+        if (intersects_sorted(t->UpdateSet, older->ReadSet)) return true;
+        if (intersects_sorted(t->WriteSet, older->UpdateSet)) return true;
+        if (intersects_sorted(t->ReadSet,  older->UpdateSet)) return true;
+        if (updatesConflict(t->UpdateSet, older->UpdateSet)) return true;
+        if (rangeConflict(*t, *older) || rangeConflict(*older, *t)) return true;
     }
     return false;
 }
 
+void TxnQueue::setCompletionHandler(std::function<void(const txn_ptr&)> fn) {
+    onComplete_ = std::move(fn);
+}
+
+void TxnQueue::setCommandLog(CommandLog* log) {
+    log_ = log;
+}
+
+void TxnQueue::setOrderedAdmission(bool ordered) {
+    orderedAdmission_ = ordered;
+}
+
+Transaction::id_t TxnQueue::markBoundary(const std::function<void(Transaction::id_t)>& fn) {
+    std::lock_guard<std::mutex> lg(mtx_);
+    if (fn) fn(lastAdmittedId_);
+    return lastAdmittedId_;
+}
+
+void TxnQueue::waitForOlder(Transaction::id_t boundary) const {
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lg(mtx_);
+            bool pending = std::any_of(queue_.begin(), queue_.end(),
+                [&](const txn_ptr& x){ return x->id <= boundary; });
+            if (!pending) return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void TxnQueue::resumeAfter(Transaction::id_t lastId) {
+    std::lock_guard<std::mutex> lg(mtx_);
+    nextId_.store(lastId + 1, std::memory_order_relaxed);
+    lastAdmittedId_ = lastId;
+}
+
+void TxnQueue::completeTransaction(const txn_ptr& T, ::storageManager& store) {
+    FinishTransaction(T, store);
+    if (log_) log_->waitDurable(T->lsn);
+    T->status = TxnStatus::Committed;
+    VLL_TRACE(TraceEvent::Finish, T->id);
+    if (onComplete_) onComplete_(T);
+}
+
+void TxnQueue::runSnapshot(const txn_ptr& T, ::storageManager& store,
+                           const std::function<void(txn_ptr)>& execute) {
+    Snapshot snap = store.snapshot();
+    T->snapshotRead = true;
+    T->readTs = snap.ts();
+    executeTraced(execute, T, true);
+    T->status = TxnStatus::Committed;
+    VLL_TRACE(TraceEvent::Finish, T->id);
+    if (onComplete_) onComplete_(T);
+}
+
+void TxnQueue::setUnblockPolicy(std::shared_ptr<const UnblockPolicy> policy) {
+    policy_ = std::move(policy);
+}
+
+UnblockStats TxnQueue::unblockStats() const {
+    auto c = counters_.snapshot();
+    auto at = [&c](QueueCounter k){ return c[static_cast<std::size_t>(k)]; };
+    UnblockStats s;
+    s.none = at(QueueCounter::UnblockNone);
+    s.scanOlder = at(QueueCounter::UnblockScanOlder);
+    s.sca = at(QueueCounter::UnblockSca);
+    s.head = at(QueueCounter::UnblockHead);
+    s.scanOlderHits = at(QueueCounter::UnblockScanOlderHits);
+    s.scaHits = at(QueueCounter::UnblockScaHits);
+    s.headHits = at(QueueCounter::UnblockHeadHits);
+    s.scaDepthLimited = at(QueueCounter::UnblockScaDepthLimited);
+    return s;
+}
+
+QueueCounters TxnQueue::counters() const {
+    auto c = counters_.snapshot();
+    auto at = [&c](QueueCounter k){ return c[static_cast<std::size_t>(k)]; };
+    QueueCounters s;
+    s.admittedFree = at(QueueCounter::AdmittedFree);
+    s.admittedBlocked = at(QueueCounter::AdmittedBlocked);
+    s.scaCalls = at(QueueCounter::UnblockSca);
+    s.scaHits = at(QueueCounter::UnblockScaHits);
+    s.scaScanned = at(QueueCounter::ScaScanned);
+    s.olderComparisons = at(QueueCounter::OlderComparisons);
+    s.lockAcquires = at(QueueCounter::LockAcquires);
+    s.lockContended = at(QueueCounter::LockContended);
+    s.lockWaitNs = at(QueueCounter::LockWaitNs);
+    s.idleSleeps = at(QueueCounter::IdleSleeps);
+    s.idleWakeups = at(QueueCounter::IdleWakeups);
+    return s;
+}
+
+std::unique_lock<std::mutex> TxnQueue::lockQueue() const {
+    std::unique_lock<std::mutex> lk(mtx_, std::try_to_lock);
+    counters_.add(QueueCounter::LockAcquires);
+    if (!lk.owns_lock()) {
+        auto t0 = std::chrono::steady_clock::now();
+        lk.lock();
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+        counters_.add(QueueCounter::LockContended);
+        counters_.add(QueueCounter::LockWaitNs, static_cast<uint64_t>(ns));
+    }
+    return lk;
+}
+
+UnblockMetrics TxnQueue::metricsLocked(std::size_t maxQueueSize) const {
+    UnblockMetrics m;
+    m.queueSize = queue_.size();
+    m.maxQueueSize = maxQueueSize;
+    m.blockedCount = blocked_;
+    m.workers = workers_.load(std::memory_order_relaxed);
+    m.idleWorkers = idleWorkers_.load(std::memory_order_relaxed);
+    m.scaHitRate = scaHitRate_;
+    return m;
+}
+
+// An unblocked transaction stays in the queue as Free until
+// FinishTransaction, so younger transactions keep seeing its keys.
+txn_ptr TxnQueue::unblockLocked(const UnblockDecision& d) {
+    txn_ptr toRun = nullptr;
+
+    switch (d.action) {
+    case UnblockAction::None:
+        counters_.add(QueueCounter::UnblockNone);
+        return nullptr;
+
+    case UnblockAction::SCA: {
+        counters_.add(QueueCounter::UnblockSca);
+        if (d.scanDepth) counters_.add(QueueCounter::UnblockScaDepthLimited);
+        // Use SCA to find a blocked transaction that can run
+        std::size_t examined = 0;
+        toRun = SCA::analyze(queue_, d.scanDepth, &examined);
+        counters_.add(QueueCounter::ScaScanned, examined);
+        if (toRun) {
+            toRun->type = Transaction::Type::Free;
+            --blocked_;
+            counters_.add(QueueCounter::UnblockScaHits);
+            VLL_TRACE(TraceEvent::Unblock, toRun->id, static_cast<uint8_t>(UnblockCause::Sca));
+        }
+        scaHitRate_ = 0.9 * scaHitRate_ + (toRun ? 0.1 : 0.0);
+        break;
+    }
+
+    case UnblockAction::ScanOlder: {
+        counters_.add(QueueCounter::UnblockScanOlder);
+        // Look for blocked transactions that can now run
+        std::size_t limit = d.scanDepth ? std::min(d.scanDepth, queue_.size()) : queue_.size();
+        for (std::size_t i = 0; i < limit; ++i) {
+            const auto &cand = queue_[i];
+            if (cand->type == Transaction::Type::Blocked) {
+                std::size_t compared = 0;
+                bool conflict = conflictsWithOlder(queue_, i, compared);
+                counters_.add(QueueCounter::OlderComparisons, compared);
+                if (!conflict) {
+                    cand->type = Transaction::Type::Free;
+                    toRun = cand;
+                    --blocked_;
+                    counters_.add(QueueCounter::UnblockScanOlderHits);
+                    VLL_TRACE(TraceEvent::Unblock, toRun->id, static_cast<uint8_t>(UnblockCause::ScanOlder));
+                    break;
+                }
+            }
+        }
+        break;
+    }
+
+    case UnblockAction::Head:
+        counters_.add(QueueCounter::UnblockHead);
+        // Per paper: "a blocked transaction that reaches the front of
+        // the TxnQueue will always be able to be unblocked and executed"
+        if (!queue_.empty() && queue_.front()->type == Transaction::Type::Blocked) {
+            toRun = queue_.front();
+            toRun->type = Transaction::Type::Free;
+            --blocked_;
+            counters_.add(QueueCounter::UnblockHeadHits);
+            VLL_TRACE(TraceEvent::Unblock, toRun->id, static_cast<uint8_t>(UnblockCause::Head));
+        }
+        break;
+    }
+
+    return toRun;
+}
+
 void TxnQueue::VLLMainLoop(::storageManager& store,
                            std::function<void(txn_ptr)> execute,
                            std::function<txn_ptr()> getNewTxnRequest,
                            std::function<bool()> shouldStop,
                            std::size_t maxQueueSize,
                            bool enable_sca) {
+    const QueueFullPolicy paperPolicy(enable_sca);
+    const UnblockPolicy& policy = policy_ ? *policy_ : paperPolicy;
+
+    // Idle workers wake early when a batch makes transactions ready.
+    auto idleSleep = [this]{
+        idleWorkers_.fetch_add(1, std::memory_order_relaxed);
+        counters_.add(QueueCounter::IdleSleeps);
+        VLL_TRACE(TraceEvent::IdleBegin, 0);
+        {
+            auto lk = lockQueue();
+            if (ready_.empty() &&
+                readyCv_.wait_for(lk, std::chrono::milliseconds(1)) == std::cv_status::no_timeout)
+                counters_.add(QueueCounter::IdleWakeups);
+        }
+        VLL_TRACE(TraceEvent::IdleEnd, 0);
+        idleWorkers_.fetch_sub(1, std::memory_order_relaxed);
+    };
+
+    workers_.fetch_add(1, std::memory_order_relaxed);
     while (true) {
         txn_ptr toRun = nullptr;
 
         {
-            std::lock_guard<std::mutex> lg(mtx_);
-
-            // Per paper Section 2.5: SCA is activated only when TxnQueue is full
-            // and CPUs would otherwise be idle
-            if (queue_.size() >= maxQueueSize && enable_sca) {
-                // Use SCA to find a blocked transaction that can run
-                toRun = SCA::analyze(queue_);
-                if (toRun) {
-                    auto it = std::find_if(queue_.begin(), queue_.end(),
-                        [&](const txn_ptr& x){ return x->id == toRun->id; });
-                    if (it != queue_.end()) {
-                        (*it)->type = Transaction::Type::Free;
-                        queue_.erase(it);
-                    }
-                }
-            } else if (queue_.size() < maxQueueSize) {
-                // Queue not full: use simple conflict checking
-                // Look for blocked transactions that can now run
-                for (std::size_t i = 0; i < queue_.size(); ++i) {
-                    const auto &cand = queue_[i];
-                    if (cand->type == Transaction::Type::Blocked) {
-                        if (!conflictsWithOlder(queue_, i)) {
-                            cand->type = Transaction::Type::Free;
-                            toRun = cand;
-                            queue_.erase(queue_.begin() + static_cast<std::ptrdiff_t>(i));
-                            break;
-                        }
-                    }
-                }
+            auto lk = lockQueue();
+            if (!ready_.empty()) {
+                toRun = std::move(ready_.front());
+                ready_.pop_front();
             } else {
-                // Queue full but SCA disabled: only run front of queue
-                // Per paper: "a blocked transaction that reaches the front of
-                // the TxnQueue will always be able to be unblocked and executed"
-                if (!queue_.empty() && queue_.front()->type == Transaction::Type::Blocked) {
-                    toRun = queue_.front();
-                    toRun->type = Transaction::Type::Free;
-                    queue_.pop_front();
-                }
+                toRun = unblockLocked(policy.decide(metricsLocked(maxQueueSize)));
             }
         }
 
         if (toRun) {
-            execute(toRun);
-            FinishTransaction(toRun, store);
+            executeTraced(execute, toRun);
+            completeTransaction(toRun, store);
             continue;
         }
 
+        bool full;
         {
-            std::lock_guard<std::mutex> lg(mtx_);
-            if (queue_.size() >= maxQueueSize) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            auto lk = lockQueue();
+            full = queue_.size() >= maxQueueSize;
+        }
+        if (full) {
+            idleSleep();
+            continue;
+        }
+
+        txn_ptr req;
+        bool admittedFree = false;
+        bool snapshot = false;
+        {
+            std::unique_lock<std::mutex> al(admitMtx_, std::defer_lock);
+            if (orderedAdmission_ && !al.try_lock()) {
+                std::this_thread::yield();
                 continue;
             }
+            req = getNewTxnRequest();
+            if (req && store.versioned() && req->WriteSet.empty() && req->UpdateSet.empty() &&
+                req->ReadRanges.empty())
+                snapshot = true;
+            else if (req)
+                admittedFree = BeginTransaction(req, store);
         }
 
-        txn_ptr req = getNewTxnRequest();
         if (!req) {
             if (shouldStop && shouldStop()) {
                 std::lock_guard<std::mutex> lg(mtx_);
-                if (queue_.empty()) return;
+                if (queue_.empty()) break;
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            idleSleep();
             continue;
         }
 
-        BeginTransaction(req, store);
-
-        if (req->type == Transaction::Type::Free) {
-            execute(req);
-            FinishTransaction(req, store);
+        if (snapshot) {
+            runSnapshot(req, store, execute);
+        } else if (admittedFree) {
+            executeTraced(execute, req);
+            completeTransaction(req, store);
         }
     }
+    workers_.fetch_sub(1, std::memory_order_relaxed);
 }
 
 }
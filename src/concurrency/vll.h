@@ -2,22 +2,76 @@
 #define VLL_H
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <deque>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 #include "../transaction/transaction.h"
 #include "../core/vll_stman.h"
+#include "unblock_policy.h"
+#include "counters.h"
+#include "../durability/command_log.h"
 #include <functional>
 
 namespace ConcVLL {
 
+enum class QueueCounter : uint8_t {
+	AdmittedFree = 0,
+	AdmittedBlocked,
+	UnblockNone,
+	UnblockScanOlder,
+	UnblockScanOlderHits,
+	UnblockSca,
+	UnblockScaHits,
+	UnblockScaDepthLimited,
+	UnblockHead,
+	UnblockHeadHits,
+	ScaScanned,
+	OlderComparisons,
+	LockAcquires,
+	LockContended,
+	LockWaitNs,
+	IdleSleeps,
+	IdleWakeups,
+	kCount
+};
+
+// Snapshot of a TxnQueue's hot-path counters, see TxnQueue::counters().
+struct QueueCounters {
+	uint64_t admittedFree = 0;
+	uint64_t admittedBlocked = 0;
+	uint64_t scaCalls = 0;
+	uint64_t scaHits = 0;
+	uint64_t scaScanned = 0;        // queue entries SCA examined
+	uint64_t olderComparisons = 0;  // pairs conflictsWithOlder compared
+	uint64_t lockAcquires = 0;      // queue mutex, on the admission/finish/unblock paths
+	uint64_t lockContended = 0;     // acquisitions that had to wait
+	uint64_t lockWaitNs = 0;
+	uint64_t idleSleeps = 0;
+	uint64_t idleWakeups = 0;       // idle waits cut short by a ready batch
+};
+
 class TxnQueue {
 public:
 	TxnQueue();
 
-	void BeginTransaction(const txn_ptr& T, ::storageManager& store);
+	// Returns true if T was admitted free. Once the queue mutex is released
+	// another worker may unblock T, so callers must not re-check T->type.
+	bool BeginTransaction(const txn_ptr& T, ::storageManager& store);
+
+	// Admits a sequenced batch in order under one acquisition of the queue
+	// mutex. Transactions admitted free are put on a ready list that
+	// VLLMainLoop workers drain before anything else. Returns how many.
+	std::size_t BeginBatch(const std::vector<txn_ptr>& batch, ::storageManager& store);
+
+	// Blocks while maxQueueSize or more transactions are queued, or until
+	// shouldStop() holds. BeginBatch does not check the queue size, so
+	// callers that admit through it call this first for backpressure.
+	void waitForRoom(std::size_t maxQueueSize, const std::function<bool()>& shouldStop = nullptr) const;
 
 	void FinishTransaction(const txn_ptr& T, ::storageManager& store);
 
@@ -29,6 +83,9 @@ public:
 
 	void CancelAll(::storageManager& store);
 
+	// On a versioned store, read-only transactions without ranges skip
+	// admission: they take no counters, are not logged and run on a
+	// snapshot of the latest commit.
 	void VLLMainLoop(::storageManager& store,
 					 std::function<void(txn_ptr)> execute,
 					 std::function<txn_ptr()> getNewTxnRequest,
@@ -36,10 +93,81 @@ public:
 					 std::size_t maxQueueSize = 1024,
 					 bool enable_sca = true);
 
+	// Overrides the maxQueueSize/enable_sca rule of VLLMainLoop. Must be set
+	// before any worker enters the loop.
+	void setUnblockPolicy(std::shared_ptr<const UnblockPolicy> policy);
+
+	UnblockStats unblockStats() const;
+
+	// Cheap per-thread counters, summed on read; safe to call while
+	// workers run.
+	QueueCounters counters() const;
+
+	// Called once per transaction after it commits (status Committed, and
+	// durable if a command log is set) or is cancelled (status Aborted).
+	// Runs on the worker thread; must be set before workers start.
+	void setCompletionHandler(std::function<void(const txn_ptr&)> fn);
+
+	// Logs every admitted transaction (and every cancellation) in queue
+	// order; workers wait for durability before marking a txn committed.
+	// Must be set before any transaction is admitted.
+	void setCommandLog(CommandLog* log);
+
+	// When set, a worker fetches a request and admits it as one step so the
+	// queue order equals the order getNewTxnRequest hands them out. Replay
+	// relies on this to reproduce the logged order.
+	void setOrderedAdmission(bool ordered);
+
+	// Runs fn(boundary) while no transaction is being admitted; boundary is
+	// the id of the last admitted transaction, which is also returned.
+	Transaction::id_t markBoundary(const std::function<void(Transaction::id_t)>& fn);
+
+	// Blocks until every transaction with id <= boundary has left the queue.
+	void waitForOlder(Transaction::id_t boundary) const;
+
+	// Continues id assignment after lastId, e.g. after loading a checkpoint.
+	void resumeAfter(Transaction::id_t lastId);
+
 private:
+	bool admitLocked(const txn_ptr& T, ::storageManager& store);
+	void completeTransaction(const txn_ptr& T, ::storageManager& store);
+	// Locks mtx_, counting acquisitions and time spent waiting.
+	std::unique_lock<std::mutex> lockQueue() const;
+	void runSnapshot(const txn_ptr& T, ::storageManager& store,
+					 const std::function<void(txn_ptr)>& execute);
+
+	tuple* lookupOrCreateLocked(const KeyHandle& key, ::storageManager& store);
+	void acquireRangesLocked(Transaction& T, ::storageManager& store);
+	void releaseRangesLocked(const Transaction& T, ::storageManager& store);
+	static void releaseRecords(const Transaction& T);
+
+	UnblockMetrics metricsLocked(std::size_t maxQueueSize) const;
+	txn_ptr unblockLocked(const UnblockDecision& d);
+
 	mutable std::mutex mtx_;
 	std::deque<txn_ptr> queue_;
+	// Free transactions from BeginBatch not yet picked up by a worker; they
+	// are also in queue_.
+	std::deque<txn_ptr> ready_;
+	std::condition_variable readyCv_;
+	// waitForRoom callers; FinishTransaction only signals when there are any.
+	mutable std::condition_variable roomCv_;
+	mutable std::size_t roomWaiters_ = 0;
+	// Ranges held by queued scans; they point into the owning txn, which
+	// the queue keeps alive.
+	std::vector<std::pair<Transaction::id_t, const KeyRange*>> activeRanges_;
+	std::size_t blocked_ = 0;
+	double scaHitRate_ = 1.0;
+	mutable PerThreadCounters<QueueCounter> counters_;
+	std::shared_ptr<const UnblockPolicy> policy_;
+	CommandLog* log_ = nullptr;
+	std::function<void(const txn_ptr&)> onComplete_;
+	bool orderedAdmission_ = false;
+	std::mutex admitMtx_;
+	std::atomic<std::size_t> workers_{0};
+	std::atomic<std::size_t> idleWorkers_{0};
 	std::atomic<Transaction::id_t> nextId_{1};
+	Transaction::id_t lastAdmittedId_ = 0;
 };
 
 }
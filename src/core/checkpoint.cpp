@@ -0,0 +1,316 @@
+#include "checkpoint.h"
+#include "vll_stman.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Buffered sequential writer that tracks the current file offset.
+class FileWriter {
+public:
+    explicit FileWriter(const std::string& path) : path_(path) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) throw_errno("open " + path);
+        buf_.reserve(kBufSize);
+    }
+
+    ~FileWriter() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    uint64_t offset() const { return offset_; }
+
+    void append(const void* p, std::size_t n) {
+        const char* c = static_cast<const char*>(p);
+        if (buf_.size() + n > kBufSize) drain();
+        if (n > kBufSize) {
+            writeRaw(c, n);
+        } else {
+            buf_.insert(buf_.end(), c, c + n);
+        }
+        offset_ += n;
+    }
+
+    void pwriteAt(const void* p, std::size_t n, uint64_t off) {
+        drain();
+        if (::pwrite(fd_, p, n, static_cast<off_t>(off)) != static_cast<ssize_t>(n)) {
+            throw_errno("pwrite " + path_);
+        }
+    }
+
+    void sync() {
+        drain();
+        if (::fdatasync(fd_) != 0) throw_errno("fdatasync " + path_);
+    }
+
+private:
+    static constexpr std::size_t kBufSize = 4 << 20;
+
+    void drain() {
+        writeRaw(buf_.data(), buf_.size());
+        buf_.clear();
+    }
+
+    void writeRaw(const char* p, std::size_t n) {
+        while (n > 0) {
+            ssize_t w = ::write(fd_, p, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                throw_errno("write " + path_);
+            }
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+    }
+
+    std::string path_;
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+    std::vector<char> buf_;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+}
+
+template <class ValueOf>
+CheckpointInfo Checkpoint::writeWith(storageManager& store, const std::string& path,
+                                     uint64_t boundaryId, ValueOf valueOf) {
+    auto start = std::chrono::steady_clock::now();
+    std::string tmp = path + ".tmp";
+    std::vector<Entry> index;
+    index.reserve(store.index_.size());
+
+    CheckpointInfo info;
+    info.boundaryId = boundaryId;
+    {
+        FileWriter out(tmp);
+        Header h{};
+        out.append(&h, sizeof(h));
+
+        // Key order, so load() appends to the ordered index in linear time.
+        for (auto it = store.index_.begin(); it.valid(); it.next()) {
+            std::string_view key = it.key();
+            Entry e;
+            auto value = valueOf(*it.value(), e.num);
+            if (!value) continue;
+            e.keyOffset = out.offset();
+            e.keyLen = static_cast<uint32_t>(key.size());
+            out.append(key.data(), key.size());
+            e.valueOffset = out.offset();
+            e.valueLen = static_cast<uint32_t>(value->size());
+            out.append(value->data(), value->size());
+            index.push_back(e);
+        }
+
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.count = index.size();
+        h.boundaryId = boundaryId;
+        static const char pad[alignof(Entry)] = {};
+        out.append(pad, (alignof(Entry) - out.offset() % alignof(Entry)) % alignof(Entry));
+        h.indexOffset = out.offset();
+        out.append(index.data(), index.size() * sizeof(Entry));
+        out.pwriteAt(&h, sizeof(h), 0);
+        out.sync();
+
+        info.records = h.count;
+        info.bytes = out.offset();
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) throw_errno("rename " + tmp);
+    info.seconds = seconds_since(start);
+    return info;
+}
+
+CheckpointInfo Checkpoint::write(storageManager& store, const std::string& path, uint64_t boundaryId) {
+    return writeWith(store, path, boundaryId, [](tuple& t, int64_t& num) {
+        num = t.num.load(std::memory_order_relaxed);
+        return std::optional<std::string_view>(t.value.view());
+    });
+}
+
+CheckpointInfo Checkpoint::load(storageManager& store, const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw_errno("open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "stat " + path);
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    if (size < sizeof(Header)) {
+        ::close(fd);
+        throw std::runtime_error("checkpoint too short: " + path);
+    }
+    void* m = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    ::close(fd);
+    if (m == MAP_FAILED) throw std::system_error(err, std::generic_category(), "mmap " + path);
+    std::shared_ptr<const void> mapping(m, [size](const void* p){ ::munmap(const_cast<void*>(p), size); });
+
+    const char* base = static_cast<const char*>(m);
+    Header h;
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("not a checkpoint: " + path);
+    }
+    // Written so that none of these can overflow.
+    auto fits = [size](uint64_t off, uint64_t len) { return off <= size && len <= size - off; };
+    if (h.indexOffset < sizeof(Header) || h.indexOffset > size ||
+        h.count > (size - h.indexOffset) / sizeof(Entry)) {
+        throw std::runtime_error("corrupt checkpoint index: " + path);
+    }
+    const char* index = base + h.indexOffset;
+    auto entry = [index](uint64_t i) {
+        Entry e;
+        std::memcpy(&e, index + i * sizeof(Entry), sizeof(Entry));
+        return e;
+    };
+    for (uint64_t i = 0; i < h.count; ++i) {
+        Entry e = entry(i);
+        if (!fits(e.keyOffset, e.keyLen) || !fits(e.valueOffset, e.valueLen)) {
+            throw std::runtime_error("corrupt checkpoint entry " + std::to_string(i) + ": " + path);
+        }
+    }
+    ::madvise(m, size, MADV_SEQUENTIAL);
+
+    store.data.reserve(store.data.size() + h.count);
+    for (uint64_t i = 0; i < h.count; ++i) {
+        Entry e = entry(i);
+        std::string_view key(base + e.keyOffset, e.keyLen);
+        auto r = store.data.try_emplace(KeyHandle(key));
+        store.values_.assign(r.first->second.value, std::string_view(base + e.valueOffset, e.valueLen));
+        if (r.second) store.index_.insert(key, &r.first->second);
+        r.first->second.num.store(e.num, std::memory_order_relaxed);
+    }
+    store.pinned_.push_back(std::move(mapping));
+
+    CheckpointInfo info;
+    info.records = h.count;
+    info.bytes = size;
+    info.boundaryId = h.boundaryId;
+    info.seconds = seconds_since(start);
+    return info;
+}
+
+void CheckpointCapture::beforeWrite(tuple& t, uint64_t writerId) {
+    if (!active.load(std::memory_order_acquire) || writerId <= boundaryId) return;
+    if (t.ckptEpoch.load(std::memory_order_acquire) == epoch) return;
+
+    Stripe& s = stripeFor(t);
+    std::lock_guard<std::mutex> lg(s.m);
+    if (active.load(std::memory_order_relaxed) && t.ckptEpoch.load(std::memory_order_relaxed) != epoch) {
+        s.preserved.emplace(&t, std::make_pair(std::string(t.value.view()), t.num.load(std::memory_order_relaxed)));
+        t.ckptEpoch.store(epoch, std::memory_order_release);
+    }
+}
+
+std::unique_lock<std::mutex> CheckpointCapture::beforeUpdate(tuple& t, UpdateOp op, int64_t operand,
+                                                             uint64_t writerId) {
+    if (!active.load(std::memory_order_acquire)) return {};
+    if (writerId > boundaryId) {
+        beforeWrite(t, writerId);
+        return {};
+    }
+    Stripe& s = stripeFor(t);
+    std::unique_lock<std::mutex> lk(s.m);
+    if (t.ckptEpoch.load(std::memory_order_relaxed) == epoch) {
+        auto it = s.preserved.find(&t);
+        if (it != s.preserved.end()) it->second.second = applyUpdate(op, it->second.second, operand);
+    }
+    return lk;
+}
+
+void CheckpointCapture::created(tuple& t) {
+    Stripe& s = stripeFor(t);
+    std::lock_guard<std::mutex> lg(s.m);
+    if (!active.load(std::memory_order_relaxed)) return;
+    s.created.insert(&t);
+    // Nothing to preserve for writers of a record the checkpoint skips.
+    t.ckptEpoch.store(epoch, std::memory_order_release);
+}
+
+std::optional<std::string> CheckpointCapture::capture(tuple& t, int64_t& num) {
+    Stripe& s = stripeFor(t);
+    std::lock_guard<std::mutex> lg(s.m);
+    if (t.ckptEpoch.load(std::memory_order_relaxed) == epoch) {
+        auto it = s.preserved.find(&t);
+        if (it != s.preserved.end()) {
+            std::string v = std::move(it->second.first);
+            num = it->second.second;
+            s.preserved.erase(it);
+            preservedCount.fetch_add(1, std::memory_order_relaxed);
+            return v;
+        }
+        if (s.created.erase(&t)) return std::nullopt;
+    }
+    // No writer past the boundary has touched t yet. Once the epoch is set,
+    // later writers know the record is captured and skip the copy.
+    std::string v(t.value.view());
+    num = t.num.load(std::memory_order_relaxed);
+    t.ckptEpoch.store(epoch, std::memory_order_release);
+    return v;
+}
+
+BackgroundCheckpoint::BackgroundCheckpoint(storageManager& store, std::string path)
+    : store_(store), path_(std::move(path)) {
+    if (!store_.capture_) store_.capture_.reset(new CheckpointCapture());
+    capture_ = store_.capture_.get();
+}
+
+BackgroundCheckpoint::~BackgroundCheckpoint() {
+    if (thread_.joinable()) thread_.join();
+}
+
+void BackgroundCheckpoint::begin(uint64_t boundaryId) {
+    capture_->epoch++;
+    capture_->boundaryId = boundaryId;
+    capture_->preservedCount.store(0, std::memory_order_relaxed);
+    capture_->active.store(true, std::memory_order_release);
+    store_.activeCapture_.store(capture_, std::memory_order_release);
+}
+
+void BackgroundCheckpoint::run(std::function<void()> waitDrained) {
+    thread_ = std::thread([this, waitDrained]{
+        try {
+            if (waitDrained) waitDrained();
+            info_ = Checkpoint::writeWith(store_, path_, capture_->boundaryId,
+                                          [this](tuple& t, int64_t& num){ return capture_->capture(t, num); });
+            info_.preserved = capture_->preservedCount.load(std::memory_order_relaxed);
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+
+        capture_->active.store(false, std::memory_order_release);
+        store_.activeCapture_.store(nullptr, std::memory_order_release);
+        for (auto& s : capture_->stripes) {
+            std::lock_guard<std::mutex> lg(s.m);
+            s.preserved.clear();
+            s.created.clear();
+        }
+    });
+}
+
+CheckpointInfo BackgroundCheckpoint::wait() {
+    if (thread_.joinable()) thread_.join();
+    if (error_) std::rethrow_exception(error_);
+    return info_;
+}
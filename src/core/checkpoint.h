@@ -0,0 +1,135 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "record.h"
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+class storageManager;
+
+struct CheckpointInfo {
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t boundaryId = 0;   // every txn with id <= boundaryId is reflected
+    uint64_t preserved = 0;    // pre-images kept for writers past the boundary
+    double seconds = 0.0;
+};
+
+// Snapshot of the record table. The file is laid out so that loading is a
+// single mmap plus one hash insert per record: keys are used in place from
+// the mapping and only values are copied. Records are written in key order,
+// which makes rebuilding the ordered index an append.
+//
+//   header  | key/value bytes | padding | index (count x CheckpointEntry)
+//
+// The index starts at a multiple of alignof(Entry). load() checks every
+// offset and length against the file size and rejects the file otherwise.
+// The file is written to "<path>.tmp", synced and renamed into place.
+class Checkpoint {
+public:
+    static constexpr char kMagic[8] = {'V', 'L', 'L', 'C', 'K', 'P', 'T', '2'};
+
+    struct Header {
+        char magic[8];
+        uint64_t count;
+        uint64_t boundaryId;
+        uint64_t indexOffset;
+    };
+
+    struct Entry {
+        uint64_t keyOffset;
+        uint64_t valueOffset;
+        uint32_t keyLen;
+        uint32_t valueLen;
+        int64_t num;
+    };
+
+    // Writes the store with no concurrent writers.
+    static CheckpointInfo write(storageManager& store, const std::string& path,
+                                uint64_t boundaryId = 0);
+
+    // Maps the file and inserts its records into store. The mapping stays
+    // alive for the lifetime of the store.
+    static CheckpointInfo load(storageManager& store, const std::string& path);
+
+private:
+    friend class BackgroundCheckpoint;
+
+    template <class ValueOf>
+    static CheckpointInfo writeWith(storageManager& store, const std::string& path,
+                                    uint64_t boundaryId, ValueOf valueOf);
+};
+
+// Copy-on-write state shared between storageManager::write and a running
+// BackgroundCheckpoint. A writer past the boundary preserves a record's old
+// value and numeric cell the first time it touches it; the checkpoint
+// thread reads either that pre-image or the live value, whichever comes
+// first per record. Records created while the capture is active are left
+// out of the checkpoint.
+struct CheckpointCapture {
+    static constexpr std::size_t kStripes = 256;
+
+    struct Stripe {
+        std::mutex m;
+        std::unordered_map<const tuple*, std::pair<std::string, int64_t>> preserved;
+        std::unordered_set<const tuple*> created;
+    };
+
+    std::atomic<bool> active{false};
+    std::atomic<uint64_t> preservedCount{0};
+    uint32_t epoch = 0;
+    uint64_t boundaryId = 0;
+    Stripe stripes[kStripes];
+
+    void beforeWrite(tuple& t, uint64_t writerId);
+    // Commutative updaters share a record, so one at or below the boundary
+    // can finish after a later one preserved it. Its update is applied to
+    // the pre-image as well; the returned lock must be held until it has
+    // also been applied to the record.
+    std::unique_lock<std::mutex> beforeUpdate(tuple& t, UpdateOp op, int64_t operand, uint64_t writerId);
+    void created(tuple& t);
+    // Value and numeric cell of t as of the boundary, or nothing if t did
+    // not exist then.
+    std::optional<std::string> capture(tuple& t, int64_t& num);
+
+    Stripe& stripeFor(const tuple& t) {
+        return stripes[(reinterpret_cast<uintptr_t>(&t) >> 6) % kStripes];
+    }
+};
+
+// Checkpoint taken while VLL workers keep running. begin() must be called
+// while no transaction is being admitted (see TxnQueue::markBoundary); the
+// scan starts once waitDrained() returns, i.e. every transaction up to the
+// boundary has finished. Later writers go through storageManager::write.
+// Keys created after begin(), by admission or insert, belong to transactions
+// past the boundary and are not written.
+class BackgroundCheckpoint {
+public:
+    BackgroundCheckpoint(storageManager& store, std::string path);
+    ~BackgroundCheckpoint();
+
+    BackgroundCheckpoint(const BackgroundCheckpoint&) = delete;
+    BackgroundCheckpoint& operator=(const BackgroundCheckpoint&) = delete;
+
+    void begin(uint64_t boundaryId);
+    void run(std::function<void()> waitDrained);
+    CheckpointInfo wait();
+
+private:
+    storageManager& store_;
+    std::string path_;
+    CheckpointCapture* capture_ = nullptr;
+    CheckpointInfo info_;
+    std::exception_ptr error_;
+    std::thread thread_;
+};
+
+#endif
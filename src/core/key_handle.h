@@ -0,0 +1,67 @@
+#ifndef KEY_HANDLE_H
+#define KEY_HANDLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// 64-bit MurmurHash2 (MurmurHash64A). Strong enough to use the low bits as
+// a bucket or bitset index directly.
+inline uint64_t hashKey(std::string_view key) {
+    const uint64_t m = 0xc6a4a7935bd1e995ull;
+    const int r = 47;
+    const char* p = key.data();
+    std::size_t n = key.size();
+    uint64_t h = 0x8445d61a4e774912ull ^ (n * m);
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t k;
+        std::memcpy(&k, p, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    if (n) {
+        uint64_t k = 0;
+        std::memcpy(&k, p, n);
+        h ^= k;
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+// A key and its hash, computed once when the handle is made (normally when
+// the transaction's key sets are filled) and reused by every storage, SCA
+// and lock manager lookup. Does not own the key bytes, so it cannot be
+// made from a temporary string.
+struct KeyHandle {
+    std::string_view key;
+    uint64_t hash = 0;
+
+    KeyHandle() = default;
+    KeyHandle(std::string_view k) : key(k), hash(hashKey(k)) {}
+    KeyHandle(const std::string& k) : KeyHandle(std::string_view(k)) {}
+    KeyHandle(std::string&&) = delete;
+    KeyHandle(std::string_view k, uint64_t h) : key(k), hash(h) {}
+
+    // Found only through a KeyHandle argument, so comparisons between plain
+    // strings and string_views never convert to a handle.
+    friend bool operator==(const KeyHandle& a, const KeyHandle& b) { return a.hash == b.hash && a.key == b.key; }
+    friend bool operator!=(const KeyHandle& a, const KeyHandle& b) { return !(a == b); }
+    friend bool operator==(const KeyHandle& a, std::string_view b) { return a.key == b; }
+    friend bool operator==(std::string_view a, const KeyHandle& b) { return a == b.key; }
+    // Key order, as for the string_views the sets used to hold.
+    friend bool operator<(const KeyHandle& a, const KeyHandle& b) { return a.key < b.key; }
+};
+
+struct KeyHandleHash {
+    std::size_t operator()(const KeyHandle& k) const { return static_cast<std::size_t>(k.hash); }
+};
+
+#endif
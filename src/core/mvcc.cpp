@@ -0,0 +1,175 @@
+#include "mvcc.h"
+#include "vll_stman.h"
+#include <algorithm>
+#include <functional>
+
+Snapshot& Snapshot::operator=(Snapshot&& o) noexcept {
+    if (this != &o) {
+        release();
+        state_ = o.state_;
+        slot_ = o.slot_;
+        ts_ = o.ts_;
+        o.state_ = nullptr;
+    }
+    return *this;
+}
+
+void Snapshot::release() {
+    if (!state_) return;
+    state_->slots[slot_].ts.store(VersionState::kFree, std::memory_order_release);
+    state_ = nullptr;
+}
+
+void storageManager::enableVersioning() {
+    if (versions_) return;
+    versions_.reset(new VersionState);
+    uint64_t n = 0;
+    for (auto& kv : data) {
+        tuple& t = kv.second;
+        if (t.versions.load(std::memory_order_relaxed)) continue;
+        t.versions.store(new Version(0, t.value.view(), nullptr), std::memory_order_relaxed);
+        ++n;
+    }
+    versions_->created.store(n, std::memory_order_relaxed);
+}
+
+void storageManager::pushVersionLocked(tuple& t, uint64_t ts) {
+    Version* head = t.versions.load(std::memory_order_relaxed);
+    t.versions.store(new Version(ts, t.value.view(), head), std::memory_order_release);
+    versions_->created.fetch_add(1, std::memory_order_relaxed);
+    // A record enters the candidate list on its second version and stays
+    // there until the collector trims it back to one.
+    if (head && !head->older.load(std::memory_order_relaxed))
+        versions_->gcCandidates.push_back(&t);
+}
+
+void storageManager::publishVersions(const std::vector<KeyHandle>& keys) {
+    if (!versions_ || keys.empty()) return;
+    std::lock_guard<std::mutex> lg(versions_->commitMtx);
+    uint64_t ts = ++versions_->clock;
+    for (const auto& k : keys) {
+        if (tuple* t = get(k)) pushVersionLocked(*t, ts);
+    }
+    versions_->visibleTs.store(ts, std::memory_order_release);
+}
+
+void storageManager::publishVersions(const std::vector<tuple*>& records) {
+    if (!versions_ || records.empty()) return;
+    std::lock_guard<std::mutex> lg(versions_->commitMtx);
+    uint64_t ts = ++versions_->clock;
+    for (tuple* t : records) pushVersionLocked(*t, ts);
+    versions_->visibleTs.store(ts, std::memory_order_release);
+}
+
+Snapshot storageManager::snapshot() {
+    VersionState& vs = *versions_;
+    std::size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % VersionState::kSlots;
+    std::size_t slot = start;
+    for (;;) {
+        uint64_t expected = VersionState::kFree;
+        if (vs.slots[slot].ts.compare_exchange_strong(expected, VersionState::kClaimed,
+                                                      std::memory_order_acq_rel))
+            break;
+        slot = (slot + 1) % VersionState::kSlots;
+        if (slot == start) std::this_thread::yield();
+    }
+
+    uint64_t ts;
+    for (;;) {
+        ts = vs.visibleTs.load(std::memory_order_acquire);
+        vs.slots[slot].ts.store(ts, std::memory_order_seq_cst);
+        if (vs.horizon.load(std::memory_order_seq_cst) <= ts) break;
+        vs.retries.fetch_add(1, std::memory_order_relaxed);
+    }
+    vs.snapshots.fetch_add(1, std::memory_order_relaxed);
+    return Snapshot(&vs, slot, ts);
+}
+
+const std::string* storageManager::readAt(const KeyHandle& key, uint64_t ts) {
+    // Snapshot readers are not admitted, so they may run while admission
+    // inserts new keys.
+    tuple* t = find(key.key);
+    if (!t) return nullptr;
+    Version* v = t->versions.load(std::memory_order_acquire);
+    while (v && v->ts > ts) v = v->older.load(std::memory_order_acquire);
+    return v ? &v->value : nullptr;
+}
+
+std::size_t storageManager::collectVersions() {
+    if (!versions_) return 0;
+    VersionState& vs = *versions_;
+
+    // Publish the horizon before scanning so a reader either lands in the
+    // scan or notices the horizon moved past it and retries.
+    uint64_t h = vs.visibleTs.load(std::memory_order_acquire);
+    vs.horizon.store(h, std::memory_order_seq_cst);
+    for (auto& s : vs.slots) {
+        uint64_t ts = s.ts.load(std::memory_order_seq_cst);
+        if (ts < h) h = ts;
+    }
+    // A slot still at kClaimed has not read visibleTs yet; whatever it reads
+    // will be at least the horizon published above.
+
+    std::vector<tuple*> work;
+    {
+        std::lock_guard<std::mutex> lg(vs.commitMtx);
+        work.swap(vs.gcCandidates);
+    }
+
+    std::size_t freed = 0;
+    for (tuple* t : work) {
+        Version* v = t->versions.load(std::memory_order_acquire);
+        while (v && v->ts > h) v = v->older.load(std::memory_order_acquire);
+        if (!v) continue;
+        Version* dead = v->older.exchange(nullptr, std::memory_order_acq_rel);
+        while (dead) {
+            Version* next = dead->older.load(std::memory_order_relaxed);
+            delete dead;
+            ++freed;
+            dead = next;
+        }
+    }
+
+    {
+        // A writer may already have re-listed a record trimmed above, so
+        // dedupe rather than trust either side.
+        std::lock_guard<std::mutex> lg(vs.commitMtx);
+        auto& c = vs.gcCandidates;
+        for (tuple* t : work) {
+            Version* head = t->versions.load(std::memory_order_relaxed);
+            if (head && head->older.load(std::memory_order_relaxed)) c.push_back(t);
+        }
+        std::sort(c.begin(), c.end());
+        c.erase(std::unique(c.begin(), c.end()), c.end());
+    }
+
+    vs.freed.fetch_add(freed, std::memory_order_relaxed);
+    vs.gcPasses.fetch_add(1, std::memory_order_relaxed);
+    return freed;
+}
+
+void storageManager::startVersionGC(std::chrono::milliseconds interval) {
+    if (!versions_ || versions_->gcThread.joinable()) return;
+    VersionState& vs = *versions_;
+    vs.gcThread = std::thread([this, &vs, interval] {
+        std::unique_lock<std::mutex> lk(vs.gcMtx);
+        while (!vs.gcStop) {
+            vs.gcCv.wait_for(lk, interval, [&vs] { return vs.gcStop; });
+            if (vs.gcStop) break;
+            lk.unlock();
+            collectVersions();
+            lk.lock();
+        }
+    });
+}
+
+VersionStats storageManager::versionStats() const {
+    VersionStats s;
+    if (!versions_) return s;
+    s.created = versions_->created.load(std::memory_order_relaxed);
+    s.freed = versions_->freed.load(std::memory_order_relaxed);
+    s.snapshots = versions_->snapshots.load(std::memory_order_relaxed);
+    s.snapshotRetries = versions_->retries.load(std::memory_order_relaxed);
+    s.gcPasses = versions_->gcPasses.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,95 @@
+#ifndef MVCC_H
+#define MVCC_H
+
+#include "record.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct VersionStats {
+    uint64_t created = 0;
+    uint64_t freed = 0;
+    uint64_t snapshots = 0;
+    uint64_t snapshotRetries = 0;   // snapshots that raced a GC pass
+    uint64_t gcPasses = 0;
+};
+
+// Timestamps, reader slots and GC state behind storageManager's versioned
+// mode.
+//
+// Writers publish under commitMtx: they take the next timestamp, push one
+// version per written key and only then advance visibleTs, so a reader at
+// visibleTs never sees half a commit.
+//
+// Readers announce their timestamp in a slot. The collector first publishes
+// a horizon, then scans the slots; a reader that stored its slot and still
+// sees a horizon at or below its timestamp is guaranteed to be counted by
+// that scan, otherwise it retries with a fresh timestamp.
+struct VersionState {
+    static constexpr std::size_t kSlots = 256;
+    static constexpr uint64_t kFree = UINT64_MAX;
+    static constexpr uint64_t kClaimed = UINT64_MAX - 1;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> ts{kFree};
+    };
+
+    std::mutex commitMtx;
+    uint64_t clock = 0;               // guarded by commitMtx
+    std::vector<tuple*> gcCandidates; // records with more than one version; guarded by commitMtx
+    std::atomic<uint64_t> visibleTs{0};
+    std::atomic<uint64_t> horizon{0};
+    Slot slots[kSlots];
+
+    std::atomic<uint64_t> created{0};
+    std::atomic<uint64_t> freed{0};
+    std::atomic<uint64_t> snapshots{0};
+    std::atomic<uint64_t> retries{0};
+    std::atomic<uint64_t> gcPasses{0};
+
+    std::thread gcThread;
+    std::mutex gcMtx;
+    std::condition_variable gcCv;
+    bool gcStop = false;
+
+    ~VersionState() {
+        {
+            std::lock_guard<std::mutex> lg(gcMtx);
+            gcStop = true;
+        }
+        gcCv.notify_all();
+        if (gcThread.joinable()) gcThread.join();
+    }
+};
+
+// Read view at a commit timestamp. Versions it can see are kept until it is
+// destroyed. Obtained from storageManager::snapshot().
+class Snapshot {
+public:
+    Snapshot() = default;
+    Snapshot(Snapshot&& o) noexcept { *this = std::move(o); }
+    Snapshot& operator=(Snapshot&& o) noexcept;
+    ~Snapshot() { release(); }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    bool valid() const { return state_ != nullptr; }
+    uint64_t ts() const { return ts_; }
+
+private:
+    friend class storageManager;
+    Snapshot(VersionState* s, std::size_t slot, uint64_t ts) : state_(s), slot_(slot), ts_(ts) {}
+    void release();
+
+    VersionState* state_ = nullptr;
+    std::size_t slot_ = 0;
+    uint64_t ts_ = 0;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "ordered_index.h"
+#include <new>
+
+namespace {
+constexpr std::size_t NODE_BLOCK_SIZE = 256 << 10;
+}
+
+std::string_view OrderedIndex::Iterator::key() const {
+    return node_->key;
+}
+
+tuple* OrderedIndex::Iterator::value() const {
+    return node_->value;
+}
+
+void OrderedIndex::Iterator::next() {
+    node_ = node_->next[0].load(std::memory_order_acquire);
+}
+
+OrderedIndex::OrderedIndex() {
+    head_ = newNode(std::string_view(), nullptr, kMaxHeight);
+    for (auto& t : tail_) t = head_;
+}
+
+// Nodes are trivially destructible; dropping the blocks frees them all.
+OrderedIndex::~OrderedIndex() = default;
+
+OrderedIndex::Node* OrderedIndex::newNode(std::string_view key, tuple* value, int height) {
+    std::size_t bytes = sizeof(Node) + sizeof(std::atomic<Node*>) * static_cast<std::size_t>(height - 1);
+    bytes = (bytes + alignof(Node) - 1) & ~(alignof(Node) - 1);
+    if (blocks_.empty() || blockUsed_ + bytes > blockSize_) {
+        blockSize_ = bytes > NODE_BLOCK_SIZE ? bytes : NODE_BLOCK_SIZE;
+        blocks_.emplace_back(new char[blockSize_]);
+        blockUsed_ = 0;
+    }
+    char* mem = blocks_.back().get() + blockUsed_;
+    blockUsed_ += bytes;
+    Node* n = new (mem) Node{key, value, height, {}};
+    for (int i = 0; i < height; ++i) {
+        new (&n->next[i]) std::atomic<Node*>(nullptr);
+    }
+    return n;
+}
+
+int OrderedIndex::randomHeight() {
+    // xorshift64; each extra level with probability 1/4
+    int h = 1;
+    while (h < kMaxHeight) {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 7;
+        rng_ ^= rng_ << 17;
+        if ((rng_ & 3) != 0) break;
+        ++h;
+    }
+    return h;
+}
+
+OrderedIndex::Node* OrderedIndex::findGreaterOrEqual(std::string_view key, Node** prev) const {
+    Node* x = head_;
+    int level = maxHeight_.load(std::memory_order_relaxed) - 1;
+    while (true) {
+        Node* next = x->next[level].load(std::memory_order_acquire);
+        if (next && next->key < key) {
+            x = next;
+        } else {
+            if (prev) prev[level] = x;
+            if (level == 0) return next;
+            --level;
+        }
+    }
+}
+
+void OrderedIndex::insert(std::string_view key, tuple* value) {
+    Node* prev[kMaxHeight];
+    int height = maxHeight_.load(std::memory_order_relaxed);
+
+    if (tail_[0] == head_ || tail_[0]->key < key) {
+        for (int i = 0; i < height; ++i) prev[i] = tail_[i];
+    } else {
+        Node* x = findGreaterOrEqual(key, prev);
+        if (x && x->key == key) {
+            x->value = value;
+            return;
+        }
+    }
+
+    int h = randomHeight();
+    if (h > height) {
+        for (int i = height; i < h; ++i) prev[i] = head_;
+        // Readers that see the new height before the links just walk
+        // through head_'s null pointers at those levels.
+        maxHeight_.store(h, std::memory_order_relaxed);
+    }
+
+    Node* x = newNode(key, value, h);
+    for (int i = 0; i < h; ++i) {
+        x->next[i].store(prev[i]->next[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        prev[i]->next[i].store(x, std::memory_order_release);
+        if (!x->next[i].load(std::memory_order_relaxed)) tail_[i] = x;
+    }
+    ++size_;
+}
+
+void OrderedIndex::erase(std::string_view key) {
+    Node* prev[kMaxHeight];
+    Node* x = findGreaterOrEqual(key, prev);
+    if (!x || x->key != key) return;
+
+    for (int i = 0; i < x->height; ++i) {
+        prev[i]->next[i].store(x->next[i].load(std::memory_order_relaxed), std::memory_order_release);
+        if (tail_[i] == x) tail_[i] = prev[i];
+    }
+    // x stays allocated; concurrent readers may still be standing on it.
+    --size_;
+}
+
+OrderedIndex::Iterator OrderedIndex::seek(std::string_view key) const {
+    return Iterator(findGreaterOrEqual(key, nullptr));
+}
+
+OrderedIndex::Iterator OrderedIndex::begin() const {
+    return Iterator(head_->next[0].load(std::memory_order_acquire));
+}
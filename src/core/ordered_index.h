@@ -0,0 +1,76 @@
+#ifndef ORDERED_INDEX_H
+#define ORDERED_INDEX_H
+
+#include "record.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Skiplist over the keys of storageManager, kept next to the hash table so
+// range scans visit only the keys in range, in order. One writer at a time
+// (storageManager serializes inserts and erases); readers never lock and may
+// run concurrently with the writer. Keys are views into storage that must
+// outlive the index. Nodes come from an arena and are only freed when the
+// index is destroyed, so erasing never pulls a node from under a reader.
+class OrderedIndex {
+    struct Node;
+
+public:
+    static constexpr int kMaxHeight = 16;
+
+    class Iterator {
+    public:
+        bool valid() const { return node_ != nullptr; }
+        std::string_view key() const;
+        tuple* value() const;
+        void next();
+
+    private:
+        friend class OrderedIndex;
+        explicit Iterator(const Node* n) : node_(n) {}
+        const Node* node_;
+    };
+
+    OrderedIndex();
+    ~OrderedIndex();
+
+    OrderedIndex(const OrderedIndex&) = delete;
+    OrderedIndex& operator=(const OrderedIndex&) = delete;
+
+    // Appending past the current largest key takes a fast path, so loading
+    // keys in sorted order is linear.
+    void insert(std::string_view key, tuple* value);
+    void erase(std::string_view key);
+
+    // First entry with key >= key.
+    Iterator seek(std::string_view key) const;
+    Iterator begin() const;
+
+    std::size_t size() const { return size_; }
+
+private:
+    struct Node {
+        std::string_view key;
+        tuple* value;
+        int height;
+        std::atomic<Node*> next[1];   // actually `height` entries
+    };
+
+    Node* newNode(std::string_view key, tuple* value, int height);
+    int randomHeight();
+    Node* findGreaterOrEqual(std::string_view key, Node** prev) const;
+
+    Node* head_;
+    std::atomic<int> maxHeight_{1};
+    Node* tail_[kMaxHeight];   // last node on each level, writer-only
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t blockUsed_ = 0;
+    std::size_t blockSize_ = 0;
+    std::size_t size_ = 0;
+    uint64_t rng_ = 0x2545F4914F6CDD1Dull;
+};
+
+#endif
@@ -1,35 +1,124 @@
 #ifndef DATA_H
 #define DATA_H
 
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <atomic>
 #include <mutex>
 #include <list>
 #include <condition_variable>
 #include <thread>
+#include "key_handle.h"
+
+// Commutative operations on a record's numeric cell. Updates of one key
+// with the same operation may run concurrently in any order; different
+// operations on one key do not commute and are serialized.
+enum class UpdateOp : uint8_t { Add = 0, Min, Max };
+constexpr int kUpdateOps = 3;
+
+inline int64_t applyUpdate(UpdateOp op, int64_t cur, int64_t operand) {
+    switch (op) {
+    case UpdateOp::Add: return cur + operand;
+    case UpdateOp::Min: return operand < cur ? operand : cur;
+    case UpdateOp::Max: return operand > cur ? operand : cur;
+    }
+    return cur;
+}
+
+struct CommutativeUpdate {
+    KeyHandle key;
+    UpdateOp op;
+    int64_t operand;
+};
+
+// Committed value of a record as of commit timestamp ts. Chains run newest
+// first; see storageManager::enableVersioning.
+struct Version {
+    uint64_t ts;
+    std::string value;
+    std::atomic<Version*> older;
+
+    Version(uint64_t t, std::string_view v, Version* o) : ts(t), value(v), older(o) {}
+};
+
+// A record's value bytes. Values of up to kInline bytes are stored in the
+// record itself; longer ones live in a block of the store's ValueSlab,
+// which is the only thing that changes a value (see ValueSlab::assign).
+// The record never owns heap memory of its own.
+class RecordValue {
+public:
+    static constexpr uint32_t kInline = 24;
+
+    RecordValue() : len_(0), cap_(kInline) {}
+    RecordValue(const RecordValue&) = delete;
+    RecordValue& operator=(const RecordValue&) = delete;
+
+    std::string_view view() const { return std::string_view(data(), len_); }
+    std::size_t size() const { return len_; }
+    std::size_t capacity() const { return cap_; }
+    bool isInline() const { return cap_ == kInline; }
+
+    const char* data() const { return isInline() ? inline_ : ext_; }
+
+private:
+    friend class ValueSlab;
+
+    char* buf() { return isInline() ? inline_ : ext_; }
+
+    uint32_t len_;
+    uint32_t cap_;
+    union {
+        char inline_[kInline];
+        char* ext_;
+    };
+};
+
 struct tuple{
     std::atomic<int> Cx;
     std::atomic<int> Cs;
-    std::string value;
+    std::atomic<int> Cc[kUpdateOps];  // commutative updaters, per UpdateOp
+    std::atomic<uint32_t> ckptEpoch;  // last checkpoint that captured this record
+    RecordValue value;                // assigned through storageManager
+    std::atomic<int64_t> num;         // numeric cell; commutative updates only, not versioned
+    std::atomic<Version*> versions;   // null unless the store is versioned
 
-    tuple(const std::string& val) : Cx(0), Cs(0), value(val) {}
-};
+    tuple() : Cx(0), Cs(0), ckptEpoch(0), num(0), versions(nullptr) {
+        for (auto& c : Cc) c.store(0, std::memory_order_relaxed);
+    }
 
-enum class LockMode { Shared, Exclusive };
+    int updaters() const {
+        int n = 0;
+        for (const auto& c : Cc) n += c.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    // True if an update with a different operation holds the record.
+    bool updatersOtherThan(UpdateOp op) const {
+        for (int i = 0; i < kUpdateOps; ++i) {
+            if (i != static_cast<int>(op) && Cc[i].load(std::memory_order_relaxed) > 0) return true;
+        }
+        return false;
+    }
 
-struct LockRequest {
-    std::condition_variable cv;
-    LockMode mode;
-    bool granted = false;
-    std::thread::id owner;
+    ~tuple() {
+        Version* v = versions.load(std::memory_order_relaxed);
+        while (v) {
+            Version* next = v->older.load(std::memory_order_relaxed);
+            delete v;
+            v = next;
+        }
+    }
 };
 
+enum class LockMode { Shared, Exclusive };
+
 struct LockHead {
-    std::mutex mtx;
     LockMode current_mode = LockMode::Shared;
     int shared_count = 0;
     bool exclusive = false;
-    std::list<std::shared_ptr<LockRequest>> queue;
+    int update_count[kUpdateOps] = {};
 };
 
 #endif
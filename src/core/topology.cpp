@@ -0,0 +1,167 @@
+#include "topology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+int read_int(const std::string& path, int fallback) {
+    std::ifstream in(path);
+    int v;
+    return (in >> v) ? v : fallback;
+}
+
+// Parses a sysfs cpu list such as "0-3,8,10-11".
+std::vector<int> parse_cpu_list(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (part.empty()) continue;
+        std::size_t dash = part.find('-');
+        int lo = std::stoi(part.substr(0, dash));
+        int hi = dash == std::string::npos ? lo : std::stoi(part.substr(dash + 1));
+        for (int c = lo; c <= hi; ++c) out.push_back(c);
+    }
+    return out;
+}
+
+// Physical cores first, then their SMT siblings.
+std::vector<int> cores_first(const std::vector<CpuTopology::Cpu>& cpus) {
+    std::vector<int> primary, siblings;
+    std::set<std::pair<int, int>> seen;
+    for (const auto& c : cpus) {
+        if (seen.insert({c.socket, c.core}).second) primary.push_back(c.id);
+        else siblings.push_back(c.id);
+    }
+    primary.insert(primary.end(), siblings.begin(), siblings.end());
+    return primary;
+}
+
+}
+
+CpuTopology CpuTopology::detect() {
+    CpuTopology topo;
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        unsigned n = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < n; ++i) CPU_SET(i, &allowed);
+    }
+
+    std::map<int, int> node_of;
+    for (int node = 0;; ++node) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!in) break;
+        std::string list;
+        std::getline(in, list);
+        for (int c : parse_cpu_list(list)) node_of[c] = node;
+    }
+
+    std::set<int> nodes;
+    for (int id = 0; id < CPU_SETSIZE; ++id) {
+        if (!CPU_ISSET(id, &allowed)) continue;
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+        Cpu c;
+        c.id = id;
+        c.core = read_int(base + "core_id", id);
+        c.socket = read_int(base + "physical_package_id", 0);
+        auto it = node_of.find(id);
+        c.node = it != node_of.end() ? it->second : 0;
+        topo.cpus.push_back(c);
+        nodes.insert(c.node);
+    }
+    std::sort(topo.cpus.begin(), topo.cpus.end(), [](const Cpu& a, const Cpu& b) {
+        return std::tie(a.node, a.socket, a.core, a.id) < std::tie(b.node, b.socket, b.core, b.id);
+    });
+    topo.nodes = std::max<int>(1, static_cast<int>(nodes.size()));
+    return topo;
+}
+
+std::string CpuTopology::describe() const {
+    std::set<std::pair<int, int>> cores;
+    std::set<int> sockets;
+    for (const auto& c : cpus) {
+        cores.insert({c.socket, c.core});
+        sockets.insert(c.socket);
+    }
+    std::ostringstream os;
+    os << cpus.size() << " cpus, " << cores.size() << " cores, " << sockets.size()
+       << " sockets, " << nodes << " nodes";
+    return os.str();
+}
+
+PinStrategy parsePinStrategy(const std::string& s) {
+    if (s == "none") return PinStrategy::None;
+    if (s == "compact") return PinStrategy::Compact;
+    if (s == "scatter") return PinStrategy::Scatter;
+    throw std::invalid_argument("unknown pin strategy: " + s);
+}
+
+const char* pinStrategyName(PinStrategy s) {
+    switch (s) {
+    case PinStrategy::Compact: return "compact";
+    case PinStrategy::Scatter: return "scatter";
+    default: return "none";
+    }
+}
+
+std::vector<int> placementPlan(const CpuTopology& topo, PinStrategy s, std::size_t n) {
+    if (s == PinStrategy::None || topo.cpus.empty()) return std::vector<int>(n, -1);
+
+    std::map<int, std::vector<CpuTopology::Cpu>> by_node;
+    for (const auto& c : topo.cpus) by_node[c.node].push_back(c);
+
+    std::vector<int> order;
+    if (s == PinStrategy::Compact) {
+        for (const auto& kv : by_node) {
+            auto node_order = cores_first(kv.second);
+            order.insert(order.end(), node_order.begin(), node_order.end());
+        }
+    } else {
+        std::vector<std::vector<int>> per_node;
+        for (const auto& kv : by_node) per_node.push_back(cores_first(kv.second));
+        for (std::size_t i = 0; order.size() < topo.cpus.size(); ++i) {
+            for (const auto& v : per_node) {
+                if (i < v.size()) order.push_back(v[i]);
+            }
+        }
+    }
+
+    std::vector<int> plan(n);
+    for (std::size_t i = 0; i < n; ++i) plan[i] = order[i % order.size()];
+    return plan;
+}
+
+bool pinThisThread(int cpu) {
+    if (cpu < 0) return true;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+int nodeOfCpu(const CpuTopology& topo, int cpu) {
+    for (const auto& c : topo.cpus) {
+        if (c.id == cpu) return c.node;
+    }
+    return 0;
+}
+
+void runPinned(int cpu, const std::function<void()>& fn) {
+    std::thread t([cpu, &fn] {
+        pinThisThread(cpu);
+        fn();
+    });
+    t.join();
+}
@@ -0,0 +1,53 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// CPUs this process may run on, with their core, socket and NUMA node as
+// reported by sysfs. Missing sysfs entries degrade to one socket and one
+// node rather than failing.
+struct CpuTopology {
+    struct Cpu {
+        int id;
+        int core;      // physical core id, unique only within a socket
+        int socket;
+        int node;
+    };
+
+    std::vector<Cpu> cpus;   // sorted by (node, socket, core, id)
+    int nodes = 1;
+
+    static CpuTopology detect();
+
+    std::string describe() const;
+};
+
+enum class PinStrategy {
+    None,       // leave placement to the scheduler
+    Compact,    // fill one node's physical cores, then SMT siblings, then the next node
+    Scatter     // round-robin across nodes, one physical core at a time
+};
+
+// Parses "none", "compact" or "scatter"; throws std::invalid_argument.
+PinStrategy parsePinStrategy(const std::string& s);
+const char* pinStrategyName(PinStrategy s);
+
+// CPU id for each of n threads, or -1 for every thread under
+// PinStrategy::None. Wraps around when n exceeds the CPU count.
+std::vector<int> placementPlan(const CpuTopology& topo, PinStrategy s, std::size_t n);
+
+// Binds the calling thread to cpu; cpu < 0 is a no-op. Returns false if
+// the kernel refused.
+bool pinThisThread(int cpu);
+
+// Node that owns cpu, or 0 if unknown.
+int nodeOfCpu(const CpuTopology& topo, int cpu);
+
+// Runs fn on a thread bound to cpu and waits for it, so memory fn touches
+// first is placed on that CPU's node.
+void runPinned(int cpu, const std::function<void()>& fn);
+
+#endif
@@ -0,0 +1,99 @@
+#include "value_slab.h"
+#include <cstring>
+
+ValueSlab::~ValueSlab() = default;
+
+std::size_t ValueSlab::classSize(int c) {
+    if (c < 15) return std::size_t(32 + 16 * c);
+    c -= 15;
+    std::size_t base = std::size_t(256) << (c / 4);
+    return base + base / 4 * (c % 4 + 1);
+}
+
+int ValueSlab::classFor(std::size_t n) {
+    for (int c = 0; c < kClasses; ++c) {
+        if (n <= classSize(c)) return c;
+    }
+    return -1;
+}
+
+char* ValueSlab::allocate(std::size_t n, uint32_t& cap) {
+    int c = classFor(n);
+    if (c < 0) {
+        cap = static_cast<uint32_t>(n);
+        reserved_.fetch_add(n, std::memory_order_relaxed);
+        oversized_.fetch_add(1, std::memory_order_relaxed);
+        return new char[n];
+    }
+    std::size_t size = classSize(c);
+    cap = static_cast<uint32_t>(size);
+    SizeClass& sc = classes_[c];
+    std::lock_guard<std::mutex> lg(sc.m);
+    if (!sc.free.empty()) {
+        char* p = sc.free.back();
+        sc.free.pop_back();
+        return p;
+    }
+    if (sc.left < size) {
+        std::unique_ptr<char[]> chunk(new char[kChunkSize]);
+        sc.next = chunk.get();
+        sc.left = kChunkSize;
+        reserved_.fetch_add(kChunkSize, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> clg(chunksMtx_);
+        chunks_.push_back(std::move(chunk));
+    }
+    char* p = sc.next;
+    sc.next += size;
+    sc.left -= size;
+    return p;
+}
+
+void ValueSlab::deallocate(char* p, uint32_t cap) {
+    int c = classFor(cap);
+    if (c < 0) {
+        delete[] p;
+        reserved_.fetch_sub(cap, std::memory_order_relaxed);
+        oversized_.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+    SizeClass& sc = classes_[c];
+    std::lock_guard<std::mutex> lg(sc.m);
+    sc.free.push_back(p);
+}
+
+void ValueSlab::assign(RecordValue& v, std::string_view bytes) {
+    if (bytes.size() <= v.cap_) {
+        // bytes may be a view of v itself.
+        std::memmove(v.buf(), bytes.data(), bytes.size());
+        v.len_ = static_cast<uint32_t>(bytes.size());
+        return;
+    }
+    uint32_t cap;
+    char* p = allocate(bytes.size(), cap);
+    std::memcpy(p, bytes.data(), bytes.size());
+    release(v);
+    v.ext_ = p;
+    v.cap_ = cap;
+    v.len_ = static_cast<uint32_t>(bytes.size());
+    used_.fetch_add(cap, std::memory_order_relaxed);
+    blocks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ValueSlab::release(RecordValue& v) {
+    if (!v.isInline()) {
+        used_.fetch_sub(v.cap_, std::memory_order_relaxed);
+        blocks_.fetch_sub(1, std::memory_order_relaxed);
+        deallocate(v.ext_, v.cap_);
+        v.cap_ = RecordValue::kInline;
+    }
+    v.len_ = 0;
+}
+
+ValueSlabStats ValueSlab::stats() const {
+    ValueSlabStats s;
+    s.reservedBytes = reserved_.load(std::memory_order_relaxed);
+    s.usedBytes = used_.load(std::memory_order_relaxed);
+    s.blocks = blocks_.load(std::memory_order_relaxed);
+    s.oversized = oversized_.load(std::memory_order_relaxed);
+    return s;
+}
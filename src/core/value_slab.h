@@ -0,0 +1,72 @@
+#ifndef VALUE_SLAB_H
+#define VALUE_SLAB_H
+
+#include "record.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+struct ValueSlabStats {
+    uint64_t reservedBytes = 0;   // slab chunks and oversized blocks
+    uint64_t usedBytes = 0;       // blocks currently holding a value
+    uint64_t blocks = 0;
+    uint64_t oversized = 0;       // values above the largest size class
+};
+
+// Size-class allocator for record values too long to store inline. Blocks
+// are carved from large chunks, so an out-of-line value costs its size
+// class and no allocator header; freed blocks go back on their class's
+// free list and chunks are only released with the slab. Values above the
+// largest class get a block of their own, which must be released before
+// the slab is destroyed.
+//
+// assign() overwrites in place whenever the new bytes fit the value's
+// current capacity, which takes no lock. Callers must hold the record
+// exclusively, as for any write.
+class ValueSlab {
+public:
+    ValueSlab() = default;
+    ~ValueSlab();
+
+    ValueSlab(const ValueSlab&) = delete;
+    ValueSlab& operator=(const ValueSlab&) = delete;
+
+    void assign(RecordValue& v, std::string_view bytes);
+    // Returns v's block, if any, and leaves v empty.
+    void release(RecordValue& v);
+
+    ValueSlabStats stats() const;
+
+private:
+    // 32 to 256 bytes in 16-byte steps, then four classes per doubling up
+    // to 4 KiB, so a block wastes at most 15 bytes or a fifth of its size.
+    static constexpr int kClasses = 31;
+    static constexpr std::size_t kChunkSize = 256 << 10;
+
+    struct SizeClass {
+        std::mutex m;
+        std::vector<char*> free;
+        char* next = nullptr;       // unused tail of the newest chunk
+        std::size_t left = 0;
+    };
+
+    static int classFor(std::size_t n);
+    static std::size_t classSize(int c);
+
+    char* allocate(std::size_t n, uint32_t& cap);
+    void deallocate(char* p, uint32_t cap);
+
+    SizeClass classes_[kClasses];
+    std::mutex chunksMtx_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    std::atomic<uint64_t> reserved_{0};
+    std::atomic<uint64_t> used_{0};
+    std::atomic<uint64_t> blocks_{0};
+    std::atomic<uint64_t> oversized_{0};
+};
+
+#endif
@@ -1,28 +1,125 @@
 #include "vll_stman.h"
-#include <iostream>
+#include "checkpoint.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace {
+constexpr std::size_t KEY_CHUNK_SIZE = 1 << 20;
+}
 
 storageManager::storageManager() { }
 
-void storageManager::insert(const std::string& key, const std::string value){
-    data.erase(key);
-    data.try_emplace(key, value);
+storageManager::~storageManager() {
+    for (auto& p : data) values_.release(p.second.value);
+}
+
+std::string_view storageManager::internKey(std::string_view key){
+    if (key.size() > KEY_CHUNK_SIZE) {
+        keyChunks_.emplace_back(new char[key.size()]);
+        std::memcpy(keyChunks_.back().get(), key.data(), key.size());
+        return std::string_view(keyChunks_.back().get(), key.size());
+    }
+    if (keyChunks_.empty() || chunkUsed_ + key.size() > chunkSize_) {
+        keyChunks_.emplace_back(new char[KEY_CHUNK_SIZE]);
+        chunkUsed_ = 0;
+        chunkSize_ = KEY_CHUNK_SIZE;
+    }
+    char* dst = keyChunks_.back().get() + chunkUsed_;
+    std::memcpy(dst, key.data(), key.size());
+    chunkUsed_ += key.size();
+    return std::string_view(dst, key.size());
 }
 
-tuple* storageManager::get(const std::string& key){
+void storageManager::insert(const KeyHandle& key, std::string_view value){
+    CheckpointCapture* c = activeCapture_.load(std::memory_order_acquire);
+    auto it = data.find(key);
+    if (it != data.end()) {
+        // Not part of any transaction, so ordered after a running checkpoint.
+        if (c) c->beforeWrite(it->second, UINT64_MAX);
+        values_.assign(it->second.value, value);
+        if (versions_) {
+            std::lock_guard<std::mutex> lg(versions_->commitMtx);
+            uint64_t ts = ++versions_->clock;
+            pushVersionLocked(it->second, ts);
+            versions_->visibleTs.store(ts, std::memory_order_release);
+        }
+        return;
+    }
+    std::string_view k = internKey(key.key);
+    auto r = data.try_emplace(KeyHandle(k, key.hash));
+    // Marked before the index publishes it to the checkpoint scan.
+    if (c) c->created(r.first->second);
+    values_.assign(r.first->second.value, value);
+    index_.insert(k, &r.first->second);
+    if (versions_) {
+        // Inserts are not transactional, so every snapshot sees the new key.
+        r.first->second.versions.store(new Version(0, value, nullptr), std::memory_order_release);
+        versions_->created.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+tuple* storageManager::get(const KeyHandle& key){
     auto it = data.find(key);
     return it != data.end() ? &it->second : nullptr;
 }
 
-void storageManager::remove(const std::string& key){
-    data.erase(key);
+tuple* storageManager::find(std::string_view key) const {
+    auto it = index_.seek(key);
+    return it.valid() && it.key() == key ? it.value() : nullptr;
 }
 
-void storageManager::rangeQuery(const std::string& startKey, const std::string& endKey){
-    for (auto &p : data) {
-        const auto &k = p.first;
-        if (k >= startKey && k <= endKey) {
-            std::cout << k << ": " << p.second.value << '\n';
-        }
+void storageManager::remove(const KeyHandle& key){
+    auto it = data.find(key);
+    if (it == data.end()) return;
+    if (versions_) {
+        std::lock_guard<std::mutex> lg(versions_->commitMtx);
+        auto& c = versions_->gcCandidates;
+        c.erase(std::remove(c.begin(), c.end(), &it->second), c.end());
     }
+    index_.erase(key.key);
+    values_.release(it->second.value);
+    data.erase(it);
 }
 
+void storageManager::rangeQuery(const std::string& startKey, const std::string& endKey,
+                                const std::function<bool(std::string_view, tuple&)>& fn){
+    std::string_view end(endKey);
+    for (auto it = index_.seek(startKey); it.valid() && it.key() <= end; it.next()) {
+        if (!fn(it.key(), *it.value())) break;
+    }
+}
+
+void storageManager::write(tuple* t, std::string_view value, uint64_t writerId){
+    if (CheckpointCapture* c = activeCapture_.load(std::memory_order_acquire)) {
+        c->beforeWrite(*t, writerId);
+    }
+    values_.assign(t->value, value);
+}
+
+void storageManager::update(tuple* t, UpdateOp op, int64_t operand, uint64_t writerId){
+    std::unique_lock<std::mutex> captured;
+    if (CheckpointCapture* c = activeCapture_.load(std::memory_order_acquire)) {
+        captured = c->beforeUpdate(*t, op, operand, writerId);
+    }
+    if (op == UpdateOp::Add) {
+        t->num.fetch_add(operand, std::memory_order_relaxed);
+        return;
+    }
+    int64_t cur = t->num.load(std::memory_order_relaxed);
+    while (op == UpdateOp::Min ? operand < cur : operand > cur) {
+        if (t->num.compare_exchange_weak(cur, operand, std::memory_order_relaxed)) break;
+    }
+}
+
+uint64_t storageManager::checksum() const {
+    std::hash<std::string_view> key_hasher;
+    std::hash<std::string_view> hasher;
+    uint64_t sum = 0;
+    for (auto &p : data) {
+        uint64_t h = key_hasher(p.first.key) * 0x9E3779B97F4A7C15ull;
+        uint64_t num = static_cast<uint64_t>(p.second.num.load(std::memory_order_relaxed));
+        sum += h ^ (hasher(p.second.value.view()) + num * 0xC2B2AE3D27D4EB4Full);
+    }
+    return sum;
+}
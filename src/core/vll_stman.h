@@ -2,20 +2,99 @@
 #define STORAGE_MANAGER_H
 
 #include "record.h"
+#include "key_handle.h"
+#include "ordered_index.h"
+#include "mvcc.h"
+#include "value_slab.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <vector>
+
+struct CheckpointCapture;
 
 class storageManager {
 
   private:
-    std::unordered_map<std::string, tuple> data;
+    // Keys are views into memory the store owns: its key arena or a mapped
+    // checkpoint file. Removing a key does not reclaim its bytes. Lookups
+    // by KeyHandle reuse its hash instead of rehashing the key.
+    std::unordered_map<KeyHandle, tuple, KeyHandleHash> data;
+    OrderedIndex index_;
+    std::vector<std::unique_ptr<char[]>> keyChunks_;
+    std::size_t chunkUsed_ = 0;
+    std::size_t chunkSize_ = 0;
+    std::vector<std::shared_ptr<const void>> pinned_;
+    ValueSlab values_;
+
+    std::unique_ptr<CheckpointCapture> capture_;
+    std::atomic<CheckpointCapture*> activeCapture_{nullptr};
+
+    std::unique_ptr<VersionState> versions_;
+
+    std::string_view internKey(std::string_view key);
+    void pushVersionLocked(tuple& t, uint64_t ts);
+
+    friend class Checkpoint;
+    friend class BackgroundCheckpoint;
   public:
-  void insert(const std::string& key, const std::string value);
-    tuple* get(const std::string& key);
-    void remove(const std::string& key);
-    void rangeQuery(const std::string& startKey, const std::string& endKey);
+    // Adds a record, or overwrites an existing record's value in place.
+    void insert(const KeyHandle& key, std::string_view value);
+    // Hash lookup. Not safe alongside insert, which may rehash: code that
+    // runs while a TxnQueue admits (and so may create keys) uses the records
+    // looked up at admission, or find().
+    tuple* get(const KeyHandle& key);
+    // Lookup through the ordered index; safe to run alongside insert.
+    tuple* find(std::string_view key) const;
+    void remove(const KeyHandle& key);
+    // Visits the records with startKey <= key <= endKey in key order until fn
+    // returns false. Safe to run alongside insert; does not copy keys or values.
+    void rangeQuery(const std::string& startKey, const std::string& endKey,
+                    const std::function<bool(std::string_view, tuple&)>& fn);
+    // Ordered cursor positioned at the first key >= startKey.
+    OrderedIndex::Iterator scan(std::string_view startKey) const { return index_.seek(startKey); }
+    // Overwrites a record's value on behalf of transaction writerId, keeping
+    // the old value for a background checkpoint that must not see it. The
+    // bytes are copied in place when they fit the value's capacity. Read
+    // values through t->value.view().
+    void write(tuple* t, std::string_view value, uint64_t writerId);
+    // Applies a commutative update to a record's numeric cell. Safe to run
+    // concurrently with other updates of the same operation.
+    void update(tuple* t, UpdateOp op, int64_t operand, uint64_t writerId);
+    // Order-independent digest of every key/value pair, for comparing stores.
+    uint64_t checksum() const;
+    std::size_t size() const { return data.size(); }
+    // Out-of-line value storage; values of up to RecordValue::kInline bytes
+    // take none.
+    ValueSlabStats valueStats() const { return values_.stats(); }
+
+    // Multi-version snapshot reads. Once enabled, every committed write adds
+    // a version stamped with a commit timestamp, and a Snapshot sees exactly
+    // the commits up to its timestamp without touching Cx/Cs. Enable after
+    // loading the store and before transactions run.
+    void enableVersioning();
+    bool versioned() const { return versions_ != nullptr; }
+    // Called by a committing writer while it still holds its keys.
+    void publishVersions(const std::vector<KeyHandle>& keys);
+    void publishVersions(const std::vector<tuple*>& records);
+    Snapshot snapshot();
+    // Value of key as of ts, or null if it did not exist then. The pointer
+    // stays valid while a snapshot at or below ts is held. Safe to run
+    // alongside insert.
+    const std::string* readAt(const KeyHandle& key, uint64_t ts);
+    // Drops versions no snapshot can see any more; returns how many.
+    std::size_t collectVersions();
+    // Runs collectVersions every interval until the store is destroyed.
+    void startVersionGC(std::chrono::milliseconds interval);
+    VersionStats versionStats() const;
+
     storageManager();
+    ~storageManager();
 };
 
 #endif
-
@@ -0,0 +1,331 @@
+#include "command_log.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ConcVLL {
+
+namespace {
+
+std::array<uint32_t, 256> make_crc_table() {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        t[i] = c;
+    }
+    return t;
+}
+
+uint32_t crc32(const char* p, std::size_t n) {
+    static const std::array<uint32_t, 256> table = make_crc_table();
+    uint32_t c = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < n; ++i) {
+        c = table[(c ^ static_cast<uint8_t>(p[i])) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+template <class T>
+void put(std::vector<char>& out, T v) {
+    const char* b = reinterpret_cast<const char*>(&v);
+    out.insert(out.end(), b, b + sizeof(T));
+}
+
+template <class T>
+bool get(const char*& p, const char* end, T& v) {
+    if (static_cast<std::size_t>(end - p) < sizeof(T)) return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+void put_key(std::vector<char>& out, std::string_view k) {
+    put<uint32_t>(out, static_cast<uint32_t>(k.size()));
+    out.insert(out.end(), k.begin(), k.end());
+}
+
+void put_keys(std::vector<char>& out, const std::vector<KeyHandle>& keys) {
+    for (const auto& k : keys) put_key(out, k.key);
+}
+
+// Key is std::string or std::string_view (pointing into [p, end)).
+template <class Key>
+bool get_keys(const char*& p, const char* end, uint32_t n, std::vector<Key>& keys) {
+    keys.clear();
+    if (n > static_cast<std::size_t>(end - p) / sizeof(uint32_t)) return false;
+    keys.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t len;
+        if (!get(p, end, len) || static_cast<std::size_t>(end - p) < len) return false;
+        keys.emplace_back(p, len);
+        p += len;
+    }
+    return true;
+}
+
+// Reserves the length/crc header, lets fill() append the payload, then
+// patches the header in place.
+template <class Fill>
+void frame(std::vector<char>& out, Fill fill) {
+    std::size_t start = out.size();
+    out.resize(start + 2 * sizeof(uint32_t));
+    fill();
+    uint32_t len = static_cast<uint32_t>(out.size() - start - 2 * sizeof(uint32_t));
+    uint32_t crc = crc32(out.data() + start + 2 * sizeof(uint32_t), len);
+    std::memcpy(out.data() + start, &len, sizeof(len));
+    std::memcpy(out.data() + start + sizeof(len), &crc, sizeof(crc));
+}
+
+void write_all(int fd, const char* p, std::size_t n) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            std::perror("CommandLog write");
+            std::abort();
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+}
+
+constexpr std::chrono::milliseconds kIdleFlush{1};
+
+}
+
+CommandLog::CommandLog(const std::string& path, CommandLogOptions opts) : opts_(opts) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+    write_all(fd_, kMagic, sizeof(kMagic));
+    buffer_.reserve(opts_.maxBatchBytes);
+    spare_.reserve(opts_.maxBatchBytes);
+    logThread_ = std::thread([this]{ logThreadMain(); });
+}
+
+CommandLog::~CommandLog() {
+    flush();
+    {
+        std::lock_guard<std::mutex> lg(mtx_);
+        stop_ = true;
+    }
+    work_cv_.notify_one();
+    logThread_.join();
+    ::close(fd_);
+}
+
+void CommandLog::encode(const Transaction& T, std::vector<char>& out) {
+    frame(out, [&]{
+        put<uint8_t>(out, static_cast<uint8_t>(LogRecordType::Txn));
+        put<uint64_t>(out, T.id);
+        put<uint32_t>(out, static_cast<uint32_t>(T.ReadSet.size()));
+        put<uint32_t>(out, static_cast<uint32_t>(T.WriteSet.size()));
+        put_keys(out, T.ReadSet);
+        put_keys(out, T.WriteSet);
+        if (!T.ReadRanges.empty() || !T.UpdateSet.empty()) {
+            put<uint32_t>(out, static_cast<uint32_t>(T.ReadRanges.size()));
+            for (const auto& r : T.ReadRanges) {
+                put_key(out, r.lo);
+                put_key(out, r.hi);
+            }
+        }
+        if (!T.UpdateSet.empty()) {
+            put<uint32_t>(out, static_cast<uint32_t>(T.UpdateSet.size()));
+            for (const auto& u : T.UpdateSet) {
+                put<uint8_t>(out, static_cast<uint8_t>(u.op));
+                put<int64_t>(out, u.operand);
+                put_key(out, u.key.key);
+            }
+        }
+    });
+}
+
+void CommandLog::encodeAbort(Transaction::id_t id, std::vector<char>& out) {
+    frame(out, [&]{
+        put<uint8_t>(out, static_cast<uint8_t>(LogRecordType::Abort));
+        put<uint64_t>(out, id);
+    });
+}
+
+std::size_t CommandLog::decode(const char* p, const char* end, LogRecord& rec) {
+    const char* start = p;
+    uint32_t len, crc;
+    if (!get(p, end, len) || !get(p, end, crc)) return 0;
+    if (static_cast<std::size_t>(end - p) < len || crc32(p, len) != crc) return 0;
+
+    const char* body_end = p + len;
+    uint8_t type;
+    if (!get(p, body_end, type) || !get(p, body_end, rec.id)) return 0;
+    rec.type = static_cast<LogRecordType>(type);
+    rec.reads.clear();
+    rec.writes.clear();
+    if (rec.type == LogRecordType::Txn) {
+        uint32_t nreads, nwrites;
+        if (!get(p, body_end, nreads) || !get(p, body_end, nwrites)) return 0;
+        if (!get_keys(p, body_end, nreads, rec.reads)) return 0;
+        if (!get_keys(p, body_end, nwrites, rec.writes)) return 0;
+        rec.ranges.clear();
+        rec.updates.clear();
+        if (p < body_end) {
+            uint32_t nranges;
+            std::vector<std::string> bounds;
+            if (!get(p, body_end, nranges) || !get_keys(p, body_end, nranges * 2, bounds)) return 0;
+            for (std::size_t i = 0; i + 1 < bounds.size(); i += 2) {
+                rec.ranges.push_back(KeyRange{std::move(bounds[i]), std::move(bounds[i + 1])});
+            }
+        }
+        if (p < body_end) {
+            uint32_t nupdates;
+            if (!get(p, body_end, nupdates)) return 0;
+            for (uint32_t i = 0; i < nupdates; ++i) {
+                uint8_t op;
+                int64_t operand;
+                uint32_t klen;
+                if (!get(p, body_end, op) || !get(p, body_end, operand) || !get(p, body_end, klen) ||
+                    op >= kUpdateOps || static_cast<std::size_t>(body_end - p) < klen) {
+                    return 0;
+                }
+                rec.updates.push_back(CommutativeUpdate{KeyHandle(std::string_view(p, klen)),
+                                                        static_cast<UpdateOp>(op), operand});
+                p += klen;
+            }
+        }
+    }
+    return static_cast<std::size_t>(body_end - start);
+}
+
+std::size_t CommandLog::peek(const char* p, const char* end, LogRecordType& type, Transaction::id_t& id) {
+    const char* start = p;
+    uint32_t len, crc;
+    if (!get(p, end, len) || !get(p, end, crc)) return 0;
+    if (static_cast<std::size_t>(end - p) < len || crc32(p, len) != crc) return 0;
+
+    const char* body_end = p + len;
+    uint8_t t;
+    if (!get(p, body_end, t) || !get(p, body_end, id)) return 0;
+    type = static_cast<LogRecordType>(t);
+    return static_cast<std::size_t>(body_end - start);
+}
+
+CommandLog::lsn_t CommandLog::append(const Transaction& T) {
+    lsn_t lsn;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lg(mtx_);
+        encode(T, buffer_);
+        lsn = ++appended_;
+        wake = buffer_.size() >= opts_.maxBatchBytes;
+    }
+    if (wake) work_cv_.notify_one();
+    return lsn;
+}
+
+CommandLog::lsn_t CommandLog::appendAbort(Transaction::id_t id) {
+    lsn_t lsn;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lg(mtx_);
+        encodeAbort(id, buffer_);
+        lsn = ++appended_;
+        wake = buffer_.size() >= opts_.maxBatchBytes;
+    }
+    if (wake) work_cv_.notify_one();
+    return lsn;
+}
+
+void CommandLog::waitDurable(lsn_t lsn) {
+    if (!waitsForDurability()) return;
+    std::unique_lock<std::mutex> lk(mtx_);
+    if (synced_ >= lsn) return;
+    ++waiters_;
+    work_cv_.notify_one();
+    durable_cv_.wait(lk, [&]{ return synced_ >= lsn; });
+    --waiters_;
+}
+
+void CommandLog::flush() {
+    std::unique_lock<std::mutex> lk(mtx_);
+    lsn_t target = appended_;
+    if (synced_ >= target) return;
+    forceSync_ = true;
+    work_cv_.notify_one();
+    durable_cv_.wait(lk, [&]{ return synced_ >= target; });
+}
+
+CommandLogStats CommandLog::stats() const {
+    std::lock_guard<std::mutex> lg(mtx_);
+    return stats_;
+}
+
+void CommandLog::logThreadMain() {
+    auto lastSync = std::chrono::steady_clock::now();
+    lsn_t written = 0;
+    std::unique_lock<std::mutex> lk(mtx_);
+
+    while (true) {
+        // Appenders run under the TxnQueue mutex and never wake this thread;
+        // it is woken by committers waiting on durability, a full batch or a
+        // flush, and otherwise drains the buffer on a short timer.
+        work_cv_.wait_for(lk, kIdleFlush, [&]{
+            return stop_ || forceSync_ || (waiters_ > 0 && !buffer_.empty()) ||
+                   buffer_.size() >= opts_.maxBatchBytes;
+        });
+        // Under Periodic the last batch before a quiet spell may have been
+        // written inside the interval; sync it once the interval is up.
+        bool syncDue = opts_.sync == LogSyncPolicy::Periodic && synced_ < written &&
+                       std::chrono::steady_clock::now() - lastSync >= opts_.syncInterval;
+        if (buffer_.empty() && !forceSync_ && !syncDue) {
+            if (stop_) break;
+            continue;
+        }
+
+        if (opts_.groupCommitInterval.count() > 0 && !stop_ && !forceSync_ &&
+            !buffer_.empty() && buffer_.size() < opts_.maxBatchBytes) {
+            work_cv_.wait_for(lk, opts_.groupCommitInterval, [&]{
+                return stop_ || forceSync_ || buffer_.size() >= opts_.maxBatchBytes;
+            });
+        }
+
+        spare_.swap(buffer_);
+        lsn_t upto = appended_;
+        uint64_t records = upto - stats_.records;
+        bool force = forceSync_;
+        forceSync_ = false;
+        lk.unlock();
+
+        if (!spare_.empty()) write_all(fd_, spare_.data(), spare_.size());
+        written = upto;
+
+        auto now = std::chrono::steady_clock::now();
+        bool sync = force || opts_.sync == LogSyncPolicy::GroupCommit ||
+                    (opts_.sync == LogSyncPolicy::Periodic && now - lastSync >= opts_.syncInterval);
+        if (sync) {
+            if (::fdatasync(fd_) != 0) {
+                std::perror("CommandLog fdatasync");
+                std::abort();
+            }
+            lastSync = now;
+        }
+
+        lk.lock();
+        stats_.records += records;
+        stats_.bytes += spare_.size();
+        if (!spare_.empty()) ++stats_.batches;
+        if (sync) {
+            ++stats_.syncs;
+            synced_ = upto;
+        }
+        spare_.clear();
+        if (sync) durable_cv_.notify_all();
+    }
+}
+
+}
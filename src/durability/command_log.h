@@ -0,0 +1,122 @@
+#ifndef COMMAND_LOG_H
+#define COMMAND_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "../transaction/transaction.h"
+
+namespace ConcVLL {
+
+// How the log thread makes appended records durable.
+enum class LogSyncPolicy : uint8_t {
+    None = 0,     // write() only, durability left to the OS
+    Periodic,     // fdatasync once per interval while unsynced, committers never wait
+    GroupCommit   // fdatasync per batch, committers wait for their LSN
+};
+
+struct CommandLogOptions {
+    LogSyncPolicy sync = LogSyncPolicy::GroupCommit;
+    // How long the log thread lets a batch grow before writing it out.
+    std::chrono::microseconds groupCommitInterval{200};
+    std::size_t maxBatchBytes = 1 << 20;
+    // Periodic policy only: minimum spacing between syncs.
+    std::chrono::milliseconds syncInterval{10};
+};
+
+struct CommandLogStats {
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t batches = 0;
+    uint64_t syncs = 0;
+};
+
+enum class LogRecordType : uint8_t { Txn = 1, Abort = 2 };
+
+// Decoded form of one log record. Abort records carry only the id. Keys
+// point into the buffer the record was decoded from.
+struct LogRecord {
+    LogRecordType type = LogRecordType::Txn;
+    Transaction::id_t id = 0;
+    std::vector<std::string_view> reads;
+    std::vector<std::string_view> writes;
+    std::vector<KeyRange> ranges;
+    std::vector<CommutativeUpdate> updates;
+};
+
+// Logical (command) log of transaction inputs in TxnQueue order. Because VLL
+// executes equivalently to queue order, the inputs alone are enough to
+// rebuild state. Records are batched by a dedicated log thread so one sync
+// covers many transactions.
+//
+// On-disk layout: an 8-byte magic, then records of
+//   u32 payload length | u32 crc32(payload) | payload
+// where payload = u8 type | u64 id | u32 nreads | u32 nwrites | keys,
+// each key encoded as u32 length + bytes, optionally followed by
+// u32 nranges | (lo, hi) keys for scans, and then by
+// u32 nupdates | (u8 op | i64 operand | key) for commutative updates.
+class CommandLog {
+public:
+    using lsn_t = uint64_t;
+
+    static constexpr char kMagic[8] = {'V', 'L', 'L', 'C', 'L', 'O', 'G', '1'};
+
+    explicit CommandLog(const std::string& path, CommandLogOptions opts = {});
+    ~CommandLog();
+
+    CommandLog(const CommandLog&) = delete;
+    CommandLog& operator=(const CommandLog&) = delete;
+
+    // Callers must append in TxnQueue order; TxnQueue does so under its mutex.
+    lsn_t append(const Transaction& T);
+    lsn_t appendAbort(Transaction::id_t id);
+
+    // Blocks until lsn is durable under the configured policy. Returns
+    // immediately for policies that do not make committers wait.
+    void waitDurable(lsn_t lsn);
+
+    // Writes and syncs everything appended so far.
+    void flush();
+
+    bool waitsForDurability() const { return opts_.sync == LogSyncPolicy::GroupCommit; }
+
+    CommandLogStats stats() const;
+
+    static void encode(const Transaction& T, std::vector<char>& out);
+    static void encodeAbort(Transaction::id_t id, std::vector<char>& out);
+    // Parses one record from [p, end). Returns bytes consumed, or 0 if the
+    // record is truncated or fails its checksum.
+    static std::size_t decode(const char* p, const char* end, LogRecord& rec);
+    // Like decode, but only extracts the record type and id.
+    static std::size_t peek(const char* p, const char* end, LogRecordType& type, Transaction::id_t& id);
+
+private:
+    void logThreadMain();
+
+    CommandLogOptions opts_;
+    int fd_ = -1;
+
+    mutable std::mutex mtx_;
+    std::condition_variable work_cv_;
+    std::condition_variable durable_cv_;
+    std::vector<char> buffer_;
+    std::vector<char> spare_;
+    lsn_t appended_ = 0;
+    lsn_t synced_ = 0;
+    std::size_t waiters_ = 0;
+    bool forceSync_ = false;
+    bool stop_ = false;
+    CommandLogStats stats_;
+
+    std::thread logThread_;
+};
+
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include "recovery.h"
+#include "command_log.h"
+#include "../concurrency/vll.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ConcVLL {
+
+namespace {
+
+// Read-only mapping of a whole log file.
+struct MappedLog {
+    const char* base = nullptr;
+    std::size_t size = 0;
+
+    explicit MappedLog(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "stat " + path);
+        }
+        size = static_cast<std::size_t>(st.st_size);
+        if (size > 0) {
+            void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "mmap " + path);
+            }
+            ::madvise(p, size, MADV_SEQUENTIAL);
+            base = static_cast<const char*>(p);
+        }
+        ::close(fd);
+    }
+
+    ~MappedLog() {
+        if (base) ::munmap(const_cast<char*>(base), size);
+    }
+
+    MappedLog(const MappedLog&) = delete;
+    MappedLog& operator=(const MappedLog&) = delete;
+};
+
+}
+
+RecoveryStats ReplayCommandLog(const std::string& logPath,
+                               ::storageManager& store,
+                               std::function<void(txn_ptr)> execute,
+                               const RecoveryOptions& opts) {
+    RecoveryStats stats;
+    auto start = std::chrono::steady_clock::now();
+
+    MappedLog log(logPath);
+    if (log.size < sizeof(CommandLog::kMagic) ||
+        std::memcmp(log.base, CommandLog::kMagic, sizeof(CommandLog::kMagic)) != 0) {
+        throw std::runtime_error("not a command log: " + logPath);
+    }
+    const char* begin = log.base + sizeof(CommandLog::kMagic);
+    const char* end = log.base + log.size;
+
+    // Pass 1: abort records follow the transaction they cancel, so collect
+    // them before replaying anything. Also find the last intact record.
+    std::unordered_set<Transaction::id_t> aborted;
+    const char* valid_end = begin;
+    {
+        LogRecordType type;
+        Transaction::id_t id;
+        const char* p = begin;
+        while (p < end) {
+            std::size_t n = CommandLog::peek(p, end, type, id);
+            if (n == 0) {
+                stats.truncatedTail = true;
+                break;
+            }
+            if (type == LogRecordType::Abort) aborted.insert(id);
+            p += n;
+        }
+        valid_end = p;
+    }
+
+    // Pass 2: feed the surviving transactions to the VLL workers in log order.
+    TxnQueue q;
+    q.setOrderedAdmission(true);
+
+    std::mutex reader_m;
+    const char* cursor = begin;
+    bool exhausted = false;
+
+    auto getNew = [&]() -> txn_ptr {
+        std::lock_guard<std::mutex> lg(reader_m);
+        LogRecord rec;
+        while (cursor < valid_end) {
+            std::size_t n = CommandLog::decode(cursor, valid_end, rec);
+            if (n == 0) {
+                // Checksum passed but the body does not parse: the valid
+                // log ends here, as for a torn record.
+                stats.truncatedTail = true;
+                valid_end = cursor;
+                break;
+            }
+            cursor += n;
+            if (rec.type != LogRecordType::Txn) continue;
+            if (rec.id <= opts.startAfterId) { ++stats.skippedBeforeStart; continue; }
+            if (aborted.count(rec.id)) { ++stats.skippedAborted; continue; }
+
+            auto T = std::make_shared<Transaction>(rec.id);
+            // Keys stay in the mapped log, which outlives the replay.
+            T->setKeys(rec.reads, rec.writes);
+            T->ReadRanges = std::move(rec.ranges);
+            T->setUpdates(std::move(rec.updates));
+            ++stats.replayed;
+            if (rec.id > stats.maxId) stats.maxId = rec.id;
+            return T;
+        }
+        exhausted = true;
+        return nullptr;
+    };
+
+    auto done = [&]{
+        std::lock_guard<std::mutex> lg(reader_m);
+        return exhausted;
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<std::size_t>(opts.numThreads));
+    for (int i = 0; i < opts.numThreads; ++i) {
+        workers.emplace_back([&]{
+            q.VLLMainLoop(store, execute, getNew, done, opts.maxQueueSize, opts.enable_sca);
+        });
+    }
+    for (auto& t : workers) t.join();
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+}
@@ -0,0 +1,42 @@
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "../transaction/transaction.h"
+#include "../core/vll_stman.h"
+
+namespace ConcVLL {
+
+struct RecoveryOptions {
+    int numThreads = 1;
+    std::size_t maxQueueSize = 10000;
+    bool enable_sca = true;
+    // Records with a smaller id are skipped, e.g. ones already in a checkpoint.
+    Transaction::id_t startAfterId = 0;
+};
+
+struct RecoveryStats {
+    uint64_t replayed = 0;
+    uint64_t skippedAborted = 0;
+    uint64_t skippedBeforeStart = 0;
+    Transaction::id_t maxId = 0;
+    bool truncatedTail = false;   // log ended in a torn or corrupt record
+    double seconds = 0.0;
+};
+
+// Rebuilds store state by re-executing the transactions of a command log.
+// Replay goes through a fresh TxnQueue with ordered admission, so the queue
+// reproduces the logged order and non-conflicting transactions run in
+// parallel on the same Cx/Cs counters as the original execution. `execute`
+// must be the deterministic transaction logic used before the crash.
+RecoveryStats ReplayCommandLog(const std::string& logPath,
+                               ::storageManager& store,
+                               std::function<void(txn_ptr)> execute,
+                               const RecoveryOptions& opts = {});
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+#include "buffer_pool.h"
+
+namespace {
+
+void freeBlock(BufferPool::Block* b) {
+    delete[] b->data;
+    delete b;
+}
+
+BufferPool::Block* newBlock(std::size_t size) {
+    return new BufferPool::Block{new char[size], size, 0};
+}
+
+}
+
+// Free list shared with outstanding blocks' deleters.
+struct BufferPool::Shared {
+    std::mutex m;
+    std::vector<Block*> free;
+    std::size_t maxFree;
+    std::atomic<uint64_t> allocated{0};
+    std::atomic<uint64_t> reused{0};
+
+    explicit Shared(std::size_t max) : maxFree(max) {}
+
+    ~Shared() {
+        for (Block* b : free) freeBlock(b);
+    }
+};
+
+BufferPool::BufferPool(std::size_t blockSize, std::size_t maxFree)
+    : blockSize_(blockSize), shared_(std::make_shared<Shared>(maxFree)) {}
+
+std::shared_ptr<BufferPool::Block> BufferPool::acquire(std::size_t minSize) {
+    if (minSize > blockSize_) {
+        shared_->allocated.fetch_add(1, std::memory_order_relaxed);
+        return std::shared_ptr<Block>(newBlock(minSize), freeBlock);
+    }
+
+    Block* b = nullptr;
+    {
+        std::lock_guard<std::mutex> lg(shared_->m);
+        if (!shared_->free.empty()) {
+            b = shared_->free.back();
+            shared_->free.pop_back();
+        }
+    }
+    if (b) {
+        b->used = 0;
+        shared_->reused.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        b = newBlock(blockSize_);
+        shared_->allocated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::shared_ptr<Shared> shared = shared_;
+    return std::shared_ptr<Block>(b, [shared](Block* blk) {
+        {
+            std::lock_guard<std::mutex> lg(shared->m);
+            if (shared->free.size() < shared->maxFree) {
+                shared->free.push_back(blk);
+                return;
+            }
+        }
+        freeBlock(blk);
+    });
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    Stats s;
+    s.allocated = shared_->allocated.load(std::memory_order_relaxed);
+    s.reused = shared_->reused.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,46 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Recycles fixed-size byte blocks. Blocks are handed out as shared_ptr so
+// anything holding views into one (a Transaction's keys, an iovec being
+// sent) keeps it alive; the last reference puts it back on the free list.
+// Blocks may outlive the pool.
+class BufferPool {
+public:
+    struct Block {
+        char* data;
+        std::size_t size;
+        std::size_t used = 0;
+
+        std::size_t room() const { return size - used; }
+    };
+
+    struct Stats {
+        uint64_t allocated = 0;   // blocks created by new
+        uint64_t reused = 0;      // acquires served from the free list
+    };
+
+    explicit BufferPool(std::size_t blockSize, std::size_t maxFree = 1024);
+
+    // A block of at least minSize bytes, with used == 0. Requests larger
+    // than the block size get a one-off block that is not recycled.
+    std::shared_ptr<Block> acquire(std::size_t minSize = 0);
+
+    std::size_t blockSize() const { return blockSize_; }
+    Stats stats() const;
+
+private:
+    struct Shared;
+
+    std::size_t blockSize_;
+    std::shared_ptr<Shared> shared_;
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include "protocol.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Protocol {
+
+namespace {
+
+template <class T>
+void put(std::vector<char>& out, T v) {
+    const char* p = reinterpret_cast<const char*>(&v);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+template <class T>
+bool get(const char*& p, const char* end, T& v) {
+    if (static_cast<std::size_t>(end - p) < sizeof(T)) return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+void put_keys(std::vector<char>& out, const std::vector<std::string_view>& keys) {
+    for (const auto& k : keys) {
+        put<uint32_t>(out, static_cast<uint32_t>(k.size()));
+        out.insert(out.end(), k.begin(), k.end());
+    }
+}
+
+bool get_keys(const char*& p, const char* end, uint32_t n, std::vector<std::string_view>& keys) {
+    keys.clear();
+    if (n > static_cast<std::size_t>(end - p) / sizeof(uint32_t)) return false;
+    keys.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t len;
+        if (!get(p, end, len) || static_cast<std::size_t>(end - p) < len) return false;
+        keys.emplace_back(p, len);
+        p += len;
+    }
+    return true;
+}
+
+void sort_unique(std::vector<std::string_view>& keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+// Writes the frame header with a placeholder length, runs body, then
+// patches the length.
+template <class Body>
+void frame(std::vector<char>& out, FrameType type, uint64_t tag, Body body) {
+    std::size_t start = out.size();
+    put<uint32_t>(out, 0);
+    put<uint8_t>(out, static_cast<uint8_t>(type));
+    put<uint64_t>(out, tag);
+    body();
+    uint32_t len = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+    std::memcpy(out.data() + start, &len, sizeof(len));
+}
+
+bool header(const char*& p, const char* end, FrameType want, uint64_t& tag) {
+    uint32_t len;
+    uint8_t type;
+    if (!get(p, end, len) || !get(p, end, type) || !get(p, end, tag)) return false;
+    return static_cast<FrameType>(type) == want;
+}
+
+}
+
+void encodeSubmit(const SubmitRequest& req, std::vector<char>& out) {
+    frame(out, FrameType::Submit, req.tag, [&]{
+        put<uint32_t>(out, static_cast<uint32_t>(req.reads.size()));
+        put<uint32_t>(out, static_cast<uint32_t>(req.writes.size()));
+        put_keys(out, req.reads);
+        put_keys(out, req.writes);
+    });
+}
+
+void encodeAck(const Ack& ack, std::vector<char>& out) {
+    frame(out, FrameType::Ack, ack.tag, [&]{
+        put<uint8_t>(out, ack.status);
+        put<uint64_t>(out, ack.txnId);
+    });
+}
+
+void encodeAck(const Ack& ack, char* out) {
+    uint32_t len = static_cast<uint32_t>(kAckSize - sizeof(uint32_t));
+    uint8_t type = static_cast<uint8_t>(FrameType::Ack);
+    std::memcpy(out, &len, sizeof(len));
+    out += sizeof(len);
+    std::memcpy(out, &type, sizeof(type));
+    out += sizeof(type);
+    std::memcpy(out, &ack.tag, sizeof(ack.tag));
+    out += sizeof(ack.tag);
+    std::memcpy(out, &ack.status, sizeof(ack.status));
+    out += sizeof(ack.status);
+    std::memcpy(out, &ack.txnId, sizeof(ack.txnId));
+}
+
+long frameSize(const char* p, std::size_t n) {
+    uint32_t len;
+    if (n < sizeof(len)) return 0;
+    std::memcpy(&len, p, sizeof(len));
+    if (len < kHeaderSize - sizeof(len) || len > kMaxFrameSize) return -1;
+    std::size_t total = sizeof(len) + len;
+    return n < total ? 0 : static_cast<long>(total);
+}
+
+bool decodeSubmit(const char* p, std::size_t n, SubmitRequest& req) {
+    const char* end = p + n;
+    uint32_t nreads, nwrites;
+    if (!header(p, end, FrameType::Submit, req.tag)) return false;
+    if (!get(p, end, nreads) || !get(p, end, nwrites)) return false;
+    if (!get_keys(p, end, nreads, req.reads) || !get_keys(p, end, nwrites, req.writes)) return false;
+
+    sort_unique(req.reads);
+    sort_unique(req.writes);
+    std::size_t kept = 0;
+    for (std::string_view k : req.reads) {
+        if (!std::binary_search(req.writes.begin(), req.writes.end(), k)) req.reads[kept++] = k;
+    }
+    req.reads.resize(kept);
+    return true;
+}
+
+bool decodeAck(const char* p, std::size_t n, Ack& ack) {
+    const char* end = p + n;
+    if (!header(p, end, FrameType::Ack, ack.tag)) return false;
+    return get(p, end, ack.status) && get(p, end, ack.txnId);
+}
+
+}
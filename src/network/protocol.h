@@ -0,0 +1,60 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Wire format between clients and Server. Every message is a frame
+//   u32 length (of what follows) | u8 type | u64 tag | body
+// in host byte order. The tag is chosen by the client and echoed in the
+// acknowledgement, so a connection may have many requests in flight and
+// acks may come back in any order.
+//
+//   Submit: u32 nreads | u32 nwrites | keys, each u32 length + bytes
+//   Ack:    u8 status (ConcVLL::TxnStatus) | u64 txn id
+//
+// Clients may pipeline: send any number of Submits without waiting.
+namespace Protocol {
+
+enum class FrameType : uint8_t { Submit = 1, Ack = 2 };
+
+constexpr std::size_t kHeaderSize = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint64_t);
+constexpr uint32_t kMaxFrameSize = 16 << 20;
+
+// Keys are views: into the caller's strings when encoding, into the frame
+// when decoding, so a server can hand them on without copying.
+struct SubmitRequest {
+    uint64_t tag = 0;
+    std::vector<std::string_view> reads;
+    std::vector<std::string_view> writes;
+};
+
+struct Ack {
+    uint64_t tag = 0;
+    uint8_t status = 0;
+    uint64_t txnId = 0;
+};
+
+void encodeSubmit(const SubmitRequest& req, std::vector<char>& out);
+void encodeAck(const Ack& ack, std::vector<char>& out);
+
+constexpr std::size_t kAckSize = kHeaderSize + sizeof(uint8_t) + sizeof(uint64_t);
+// Writes exactly kAckSize bytes to out.
+void encodeAck(const Ack& ack, char* out);
+
+// Length of the complete frame at p, 0 if more bytes are needed, or -1 if
+// the stream is malformed.
+long frameSize(const char* p, std::size_t n);
+
+// Decode one complete frame. Return false on a malformed body or when the
+// frame has a different type. Admission relies on sorted key sets, so a
+// decoded Submit has its reads and writes sorted and free of duplicates,
+// and keys that are also written are dropped from the reads.
+bool decodeSubmit(const char* p, std::size_t n, SubmitRequest& req);
+bool decodeAck(const char* p, std::size_t n, Ack& ack);
+
+}
+
+#endif
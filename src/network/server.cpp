@@ -1,12 +1,432 @@
 #include "server.h"
-#include <iostream>
+#include "protocol.h"
 
-Server::Server(int port) : port_(port) {}
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+#include <unordered_map>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kMaxEvents = 64;
+constexpr std::size_t kRxBlockSize = 64 << 10;
+constexpr std::size_t kTxBlockSize = 4 << 10;
+constexpr std::size_t kMaxIov = 64;
+
+// epoll_event.data.ptr values that are not connections.
+char kWakeTag;
+char kListenTag;
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+}
+
+struct Server::Connection {
+    int fd;
+
+    // Receive side, only touched by the owning I/O thread. Frames are parsed
+    // in place and requests keep views into rx, which they pin.
+    std::shared_ptr<BufferPool::Block> rx;
+    std::size_t parsed = 0;
+
+    // Send side. Workers append acks to pooled blocks; whoever finds no
+    // flush in progress sends everything queued with one sendmsg, so acks
+    // that complete meanwhile ride along with the next call. The fd is only
+    // closed when no flush is in progress.
+    std::mutex m;
+    bool closed = false;
+    bool flushing = false;
+    std::deque<std::shared_ptr<BufferPool::Block>> tx;
+    std::size_t txSent = 0;   // bytes of tx.front() already sent
+
+    explicit Connection(int f) : fd(f) {}
+};
+
+// Transaction submitted over a connection; the ack goes back to conn.
+struct Server::Request : ConcVLL::Transaction {
+    std::shared_ptr<Connection> conn;
+    uint64_t tag = 0;
+
+    explicit Request(std::shared_ptr<Connection> c) : Transaction(0), conn(std::move(c)) {}
+};
+
+struct Server::IoThread {
+    int epfd = -1;
+    int wakeFd = -1;
+    std::thread thread;
+    std::mutex m;   // guards conns; accept runs on I/O thread 0
+    std::unordered_map<Connection*, std::shared_ptr<Connection>> conns;
+
+    ~IoThread() {
+        if (wakeFd >= 0) ::close(wakeFd);
+        if (epfd >= 0) ::close(epfd);
+    }
+};
+
+Server::Server(storageManager& store, ConcVLL::TxnQueue& queue,
+               std::function<void(ConcVLL::txn_ptr)> execute, ServerOptions opts)
+    : store_(store), queue_(queue), execute_(std::move(execute)), opts_(std::move(opts)),
+      rxPool_(kRxBlockSize), txPool_(kTxBlockSize) {}
+
+Server::~Server() {
+    stop();
+    if (listenFd_ >= 0) ::close(listenFd_);
+}
 
 void Server::start() {
-    std::cout << "Server starting on port " << port_ << "\n";
+    if (running_) return;
+
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) throw_errno("socket");
+    int one = 1;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(opts_.port));
+    if (::inet_pton(AF_INET, opts_.host.c_str(), &addr.sin_addr) != 1) {
+        throw std::system_error(EINVAL, std::generic_category(), "bad address " + opts_.host);
+    }
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) throw_errno("bind");
+    if (::listen(listenFd_, SOMAXCONN) != 0) throw_errno("listen");
+    socklen_t len = sizeof(addr);
+    ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    int nio = opts_.ioThreads > 0 ? opts_.ioThreads : 1;
+    for (int i = 0; i < nio; ++i) {
+        auto io = std::make_unique<IoThread>();
+        io->epfd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (io->epfd < 0) throw_errno("epoll_create1");
+        io->wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (io->wakeFd < 0) throw_errno("eventfd");
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &kWakeTag;
+        ::epoll_ctl(io->epfd, EPOLL_CTL_ADD, io->wakeFd, &ev);
+        io_.push_back(std::move(io));
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = &kListenTag;
+    if (::epoll_ctl(io_[0]->epfd, EPOLL_CTL_ADD, listenFd_, &ev) != 0) throw_errno("epoll_ctl");
+
+    queue_.setCompletionHandler([this](const ConcVLL::txn_ptr& T){ onComplete(T); });
+
+    stopping_.store(false);
+    running_ = true;
+    for (auto& io : io_) {
+        IoThread* p = io.get();
+        p->thread = std::thread([this, p]{ ioLoop(*p); });
+    }
+    // Requests arrive through BeginBatch, so the workers only run what the
+    // queue hands them.
+    for (int i = 0; i < opts_.workers; ++i) {
+        workers_.emplace_back([this]{
+            queue_.VLLMainLoop(store_, execute_, []{ return ConcVLL::txn_ptr(); },
+                               [this]{ return stopping_.load(); }, opts_.maxQueueSize, opts_.enable_sca);
+        });
+    }
 }
 
 void Server::stop() {
-    std::cout << "Server stopping\n";
+    if (!running_) return;
+    running_ = false;
+    stopping_.store(true);
+
+    for (auto& io : io_) {
+        uint64_t one = 1;
+        (void)!::write(io->wakeFd, &one, sizeof(one));
+    }
+    for (auto& io : io_) {
+        if (io->thread.joinable()) io->thread.join();
+    }
+
+    queue_.CancelAll(store_);
+    for (auto& t : workers_) t.join();
+    workers_.clear();
+    queue_.setCompletionHandler(nullptr);
+
+    for (auto& io : io_) {
+        for (auto& p : io->conns) {
+            std::lock_guard<std::mutex> lg(p.second->m);
+            p.second->closed = true;
+            if (p.second->fd >= 0) ::close(p.second->fd);
+            p.second->fd = -1;
+        }
+    }
+    io_.clear();
+    ::close(listenFd_);
+    listenFd_ = -1;
+}
+
+ServerStats Server::stats() const {
+    ServerStats s;
+    s.connections = connections_.load(std::memory_order_relaxed);
+    s.requests = requests_.load(std::memory_order_relaxed);
+    s.rejected = rejected_.load(std::memory_order_relaxed);
+    s.acks = acks_.load(std::memory_order_relaxed);
+    s.batches = batches_.load(std::memory_order_relaxed);
+    s.sends = sends_.load(std::memory_order_relaxed);
+    auto rx = rxPool_.stats();
+    s.rxBlocksAllocated = rx.allocated;
+    s.rxBlocksReused = rx.reused;
+    return s;
+}
+
+void Server::ioLoop(IoThread& io) {
+    epoll_event events[kMaxEvents];
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        int n = ::epoll_wait(io.epfd, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            void* tag = events[i].data.ptr;
+            if (tag == &kWakeTag) continue;
+            if (tag == &kListenTag) {
+                acceptAll();
+                continue;
+            }
+
+            std::shared_ptr<Connection> c;
+            {
+                std::lock_guard<std::mutex> lg(io.m);
+                auto it = io.conns.find(static_cast<Connection*>(tag));
+                if (it == io.conns.end()) continue;
+                c = it->second;
+            }
+            uint32_t e = events[i].events;
+            if (e & EPOLLOUT) {
+                std::unique_lock<std::mutex> lk(c->m);
+                if (!c->flushing) flushLocked(*c, lk);
+            }
+            if (e & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) readAll(io, c);
+        }
+    }
+}
+
+void Server::acceptAll() {
+    while (true) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return;   // EAGAIN: drained; anything else: retry on next edge
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto c = std::make_shared<Connection>(fd);
+        IoThread& io = *io_[nextIo_++ % io_.size()];
+        {
+            std::lock_guard<std::mutex> lg(io.m);
+            io.conns.emplace(c.get(), c);
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = c.get();
+        if (::epoll_ctl(io.epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            closeConnection(io, c);
+            continue;
+        }
+        connections_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Makes room in c.rx, carrying an incomplete trailing frame over to a new
+// block big enough to hold it.
+bool Server::refillRx(Connection& c) {
+    const char* tail = nullptr;
+    std::size_t pending = 0;
+    std::size_t need = 0;
+    if (c.rx) {
+        tail = c.rx->data + c.parsed;
+        pending = c.rx->used - c.parsed;
+        need = pending + 1;
+        uint32_t len;
+        if (pending >= sizeof(len)) {
+            std::memcpy(&len, tail, sizeof(len));
+            if (len > Protocol::kMaxFrameSize) return false;
+            need = std::max(need, sizeof(len) + len);
+        }
+    }
+    auto b = rxPool_.acquire(need);
+    if (pending) std::memcpy(b->data, tail, pending);
+    b->used = pending;
+    c.rx = std::move(b);
+    c.parsed = 0;
+    return true;
+}
+
+// Edge-triggered: drain the socket, then admit every complete request in
+// one batch.
+void Server::readAll(IoThread& io, const std::shared_ptr<Connection>& c) {
+    std::vector<ConcVLL::txn_ptr> batch;
+    bool eof = false;
+
+    while (!eof) {
+        if ((!c->rx || c->rx->room() == 0) && !refillRx(*c)) {
+            eof = true;
+            break;
+        }
+        BufferPool::Block& b = *c->rx;
+        ssize_t n = ::recv(c->fd, b.data + b.used, b.room(), 0);
+        if (n == 0) {
+            eof = true;
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) eof = true;
+            break;
+        }
+        b.used += static_cast<std::size_t>(n);
+
+        while (true) {
+            const char* p = b.data + c->parsed;
+            long size = Protocol::frameSize(p, b.used - c->parsed);
+            if (size == 0) break;
+            Protocol::SubmitRequest req;
+            if (size < 0 || !Protocol::decodeSubmit(p, static_cast<std::size_t>(size), req)) {
+                eof = true;
+                break;
+            }
+            c->parsed += static_cast<std::size_t>(size);
+
+            // Admission would create missing keys, racing the store lookups
+            // of running transactions; clients may only name existing ones.
+            auto known = [this](std::string_view k){ return store_.find(k) != nullptr; };
+            if (!std::all_of(req.reads.begin(), req.reads.end(), known) ||
+                !std::all_of(req.writes.begin(), req.writes.end(), known)) {
+                Protocol::Ack ack;
+                ack.tag = req.tag;
+                ack.status = static_cast<uint8_t>(ConcVLL::TxnStatus::Aborted);
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                sendAck(*c, ack);
+                continue;
+            }
+
+            auto T = std::make_shared<Request>(c);
+            T->tag = req.tag;
+            T->setKeys(req.reads, req.writes);
+            T->keyOwner = c->rx;
+            batch.push_back(std::move(T));
+        }
+    }
+
+    if (!batch.empty()) {
+        requests_.fetch_add(batch.size(), std::memory_order_relaxed);
+        // Backpressure: while the queue is full this connection is not read,
+        // so clients see TCP flow control rather than an unbounded queue.
+        queue_.waitForRoom(opts_.maxQueueSize, [this]{ return stopping_.load(std::memory_order_relaxed); });
+        if (!stopping_.load(std::memory_order_relaxed)) {
+            batches_.fetch_add(1, std::memory_order_relaxed);
+            queue_.BeginBatch(batch, store_);
+        }
+    }
+    if (eof) closeConnection(io, c);
+}
+
+void Server::closeConnection(IoThread& io, const std::shared_ptr<Connection>& c) {
+    {
+        std::lock_guard<std::mutex> lg(c->m);
+        if (c->closed) return;
+        c->closed = true;
+        ::epoll_ctl(io.epfd, EPOLL_CTL_DEL, c->fd, nullptr);
+        if (!c->flushing) {
+            ::close(c->fd);
+            c->fd = -1;
+        }
+    }
+    std::lock_guard<std::mutex> lg(io.m);
+    io.conns.erase(c.get());
+}
+
+// Sends c.tx until it is empty or the socket is full (EPOLLOUT resumes).
+// The lock is dropped around sendmsg; blocks are only ever appended to, so
+// the iovecs stay valid while other threads queue more acks.
+void Server::flushLocked(Connection& c, std::unique_lock<std::mutex>& lk) {
+    c.flushing = true;
+    while (!c.closed && !c.tx.empty()) {
+        iovec iov[kMaxIov];
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < c.tx.size() && n < kMaxIov; ++i) {
+            const BufferPool::Block& b = *c.tx[i];
+            std::size_t off = i == 0 ? c.txSent : 0;
+            if (b.used == off) continue;
+            iov[n].iov_base = b.data + off;
+            iov[n].iov_len = b.used - off;
+            ++n;
+        }
+        if (n == 0) break;
+
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n;
+        int fd = c.fd;
+        lk.unlock();
+        ssize_t w = ::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        int err = errno;
+        lk.lock();
+        sends_.fetch_add(1, std::memory_order_relaxed);
+        if (w < 0) {
+            if (err == EINTR) continue;
+            // EAGAIN waits for EPOLLOUT; real errors surface as EPOLLERR.
+            break;
+        }
+
+        std::size_t left = static_cast<std::size_t>(w);
+        while (!c.tx.empty()) {
+            BufferPool::Block& b = *c.tx.front();
+            std::size_t take = std::min(left, b.used - c.txSent);
+            c.txSent += take;
+            left -= take;
+            if (c.txSent < b.used) break;
+            c.txSent = 0;
+            if (c.tx.size() == 1) {
+                b.used = 0;   // keep the last block for the next acks
+                break;
+            }
+            c.tx.pop_front();
+        }
+    }
+    c.flushing = false;
+    if (c.closed && c.fd >= 0) {
+        ::close(c.fd);
+        c.fd = -1;
+    }
+}
+
+void Server::onComplete(const ConcVLL::txn_ptr& T) {
+    auto& r = static_cast<Request&>(*T);
+    Protocol::Ack ack;
+    ack.tag = r.tag;
+    ack.status = static_cast<uint8_t>(T->status);
+    ack.txnId = T->id;
+    sendAck(*r.conn, ack);
+}
+
+void Server::sendAck(Connection& c, const Protocol::Ack& ack) {
+    std::unique_lock<std::mutex> lk(c.m);
+    if (c.closed) return;
+    if (c.tx.empty() || c.tx.back()->room() < Protocol::kAckSize) c.tx.push_back(txPool_.acquire());
+    BufferPool::Block& b = *c.tx.back();
+    Protocol::encodeAck(ack, b.data + b.used);
+    b.used += Protocol::kAckSize;
+    acks_.fetch_add(1, std::memory_order_relaxed);
+    if (!c.flushing) flushLocked(c, lk);
 }
@@ -1,15 +1,104 @@
 #ifndef SERVER_H
 #define SERVER_H
 
+#include "../concurrency/vll.h"
+#include "buffer_pool.h"
+#include "protocol.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+struct ServerOptions {
+    std::string host = "127.0.0.1";
+    int port = 0;                       // 0 binds an ephemeral port, see Server::port()
+    int ioThreads = 2;
+    int workers = 2;                    // VLL worker threads
+    std::size_t maxQueueSize = 10000;
+    bool enable_sca = true;
+};
+
+struct ServerStats {
+    uint64_t connections = 0;
+    uint64_t requests = 0;
+    uint64_t acks = 0;
+    uint64_t rejected = 0;  // requests naming keys the store does not have
+    uint64_t batches = 0;   // BeginBatch calls from the I/O threads
+    uint64_t sends = 0;     // sendmsg calls; acks/sends is the coalescing factor
+    uint64_t rxBlocksAllocated = 0;
+    uint64_t rxBlocksReused = 0;
+};
+
+// TCP front end for a TxnQueue (see network/protocol.h for the wire format).
+// I/O threads each own an edge-triggered epoll set; connections are spread
+// over them round-robin. Requests are decoded in place from pooled receive
+// blocks and carry their keys as views pinning the block. Every request from
+// one read burst is admitted to the queue with a single BeginBatch, waiting
+// first while the queue holds maxQueueSize transactions, and the ack is sent
+// from the worker once the transaction has committed (and is durable, if
+// the queue logs); acks queued during a send are coalesced into the next
+// sendmsg. Requests naming a key the store does not have are acked Aborted
+// without being admitted: clients cannot create keys.
 class Server {
 public:
-    Server(int port);
+    Server(storageManager& store, ConcVLL::TxnQueue& queue,
+           std::function<void(ConcVLL::txn_ptr)> execute, ServerOptions opts = {});
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Binds, listens and starts the I/O and worker threads. Throws
+    // std::system_error if the socket cannot be set up.
     void start();
+    // Stops accepting, cancels queued requests that have not started and
+    // joins every thread. Requests not yet admitted are dropped unacked.
     void stop();
+
+    int port() const { return port_; }
+    ServerStats stats() const;
+
 private:
-    int port_;
+    struct Connection;
+    struct Request;
+    struct IoThread;
+
+    void ioLoop(IoThread& io);
+    void acceptAll();
+    void readAll(IoThread& io, const std::shared_ptr<Connection>& c);
+    bool refillRx(Connection& c);
+    void flushLocked(Connection& c, std::unique_lock<std::mutex>& lk);
+    void closeConnection(IoThread& io, const std::shared_ptr<Connection>& c);
+    void onComplete(const ConcVLL::txn_ptr& T);
+    void sendAck(Connection& c, const Protocol::Ack& ack);
+
+    storageManager& store_;
+    ConcVLL::TxnQueue& queue_;
+    std::function<void(ConcVLL::txn_ptr)> execute_;
+    ServerOptions opts_;
+
+    BufferPool rxPool_;
+    BufferPool txPool_;
+
+    int listenFd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stopping_{false};
+    bool running_ = false;
+    std::size_t nextIo_ = 0;
+    std::vector<std::unique_ptr<IoThread>> io_;
+    std::vector<std::thread> workers_;
+
+    std::atomic<uint64_t> connections_{0};
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> acks_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> sends_{0};
 };
 
 #endif
@@ -0,0 +1,176 @@
+#include "replication.h"
+#include "../durability/command_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace ConcVLL {
+
+namespace {
+
+template <class T>
+void put(std::vector<char>& out, T v) {
+    const char* p = reinterpret_cast<const char*>(&v);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+template <class T>
+bool get(const char*& p, const char* end, T& v) {
+    if (static_cast<std::size_t>(end - p) < sizeof(T)) return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+}
+
+void ReplicationPrimary::addReplica(std::unique_ptr<Transport> t) {
+    replicas_.push_back(std::move(t));
+}
+
+void ReplicationPrimary::ship(uint64_t epoch, const std::vector<txn_ptr>& batch) {
+    if (replicas_.empty() || batch.empty()) return;
+    auto start = std::chrono::steady_clock::now();
+
+    msg_.clear();
+    put<uint64_t>(msg_, epoch);
+    put<uint64_t>(msg_, now_ns());
+    put<uint32_t>(msg_, static_cast<uint32_t>(batch.size()));
+    for (const auto &T : batch) CommandLog::encode(*T, msg_);
+    for (auto &r : replicas_) r->send(msg_);
+
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+    std::lock_guard<std::mutex> lg(m_);
+    ++stats_.epochs;
+    stats_.txns += batch.size();
+    stats_.bytes += msg_.size();
+    stats_.shipSeconds += d.count();
+}
+
+void ReplicationPrimary::close() {
+    for (auto &r : replicas_) r->close();
+}
+
+PrimaryStats ReplicationPrimary::stats() const {
+    std::lock_guard<std::mutex> lg(m_);
+    return stats_;
+}
+
+struct Replica::EpochProgress {
+    uint64_t sealedNs;
+    std::atomic<uint32_t> remaining;
+
+    EpochProgress(uint64_t sealed, uint32_t n) : sealedNs(sealed), remaining(n) {}
+};
+
+// Keys are views into the received message, which the txn keeps alive.
+struct Replica::ReplicatedTxn : Transaction {
+    std::shared_ptr<EpochProgress> epoch;
+};
+
+Replica::Replica(::storageManager& store, std::unique_ptr<Transport> in,
+                 std::function<void(txn_ptr)> execute, ReplicaOptions opts)
+    : store_(store), in_(std::move(in)), execute_(std::move(execute)), opts_(opts) {
+    queue_.setCompletionHandler([this](const txn_ptr& T){ onComplete(T); });
+}
+
+Replica::~Replica() {
+    wait();
+}
+
+void Replica::start() {
+    receiver_ = std::thread([this]{ receiveLoop(); });
+    for (int i = 0; i < opts_.workers; ++i) {
+        workers_.emplace_back([this]{
+            queue_.VLLMainLoop(store_, execute_, []{ return txn_ptr(); },
+                               [this]{ return streamEnded_.load(); },
+                               opts_.maxQueueSize, opts_.enable_sca);
+        });
+    }
+}
+
+void Replica::wait() {
+    if (receiver_.joinable()) receiver_.join();
+    for (auto &w : workers_) if (w.joinable()) w.join();
+    workers_.clear();
+}
+
+ReplicaStats Replica::stats() const {
+    std::lock_guard<std::mutex> lg(m_);
+    ReplicaStats s = stats_;
+    s.lagAvgMs = s.epochs ? lagSumMs_ / double(s.epochs) : 0.0;
+    return s;
+}
+
+void Replica::receiveLoop() {
+    std::vector<txn_ptr> batch;
+    while (true) {
+        auto msg = std::make_shared<std::vector<char>>();
+        if (!in_->receive(*msg)) break;
+
+        const char* p = msg->data();
+        const char* end = p + msg->size();
+        uint64_t epoch, sealed;
+        uint32_t count;
+        if (!get(p, end, epoch) || !get(p, end, sealed) || !get(p, end, count)) {
+            std::lock_guard<std::mutex> lg(m_);
+            stats_.corrupt = true;
+            break;
+        }
+
+        auto progress = std::make_shared<EpochProgress>(sealed, count);
+        batch.clear();
+        bool ok = true;
+        LogRecord rec;
+        for (uint32_t i = 0; i < count; ++i) {
+            std::size_t n = CommandLog::decode(p, end, rec);
+            if (n == 0 || rec.type != LogRecordType::Txn) {
+                ok = false;
+                break;
+            }
+            p += n;
+            auto T = std::make_shared<ReplicatedTxn>();
+            T->id = rec.id;
+            T->setKeys(rec.reads, rec.writes);
+            T->ReadRanges = std::move(rec.ranges);
+            T->setUpdates(std::move(rec.updates));
+            T->keyOwner = msg;
+            T->epoch = progress;
+            batch.push_back(std::move(T));
+        }
+        if (!ok) {
+            std::lock_guard<std::mutex> lg(m_);
+            stats_.corrupt = true;
+            break;
+        }
+        if (batch.empty()) continue;
+
+        queue_.BeginBatch(batch, store_);
+        std::lock_guard<std::mutex> lg(m_);
+        stats_.bytes += msg->size();
+        stats_.lastId = std::max(stats_.lastId, batch.back()->id);
+    }
+    streamEnded_.store(true);
+}
+
+void Replica::onComplete(const txn_ptr& T) {
+    auto& progress = static_cast<ReplicatedTxn&>(*T).epoch;
+    bool last = progress->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    double lagMs = last ? double(now_ns() - progress->sealedNs) / 1e6 : 0.0;
+
+    std::lock_guard<std::mutex> lg(m_);
+    ++stats_.txns;
+    if (last) {
+        ++stats_.epochs;
+        lagSumMs_ += lagMs;
+        stats_.lagMaxMs = std::max(stats_.lagMaxMs, lagMs);
+    }
+}
+
+}
@@ -0,0 +1,111 @@
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "transport.h"
+#include "../concurrency/vll.h"
+
+namespace ConcVLL {
+
+// Deterministic replication: replicas receive only the primary's sequenced
+// epochs and admit each one in the same order, so their queues, and hence
+// their states, match the primary's. Each message is one epoch:
+//   u64 epoch | u64 sealed (steady clock ns) | u32 count | records
+// with records in CommandLog encoding.
+//
+// Cancellation is not replicated: a primary with replicas must let its
+// queue drain rather than call TxnQueue::CancelAll.
+
+struct PrimaryStats {
+    uint64_t epochs = 0;
+    uint64_t txns = 0;
+    uint64_t bytes = 0;         // per replica
+    double shipSeconds = 0.0;   // encoding and sending, on the sequencer thread
+};
+
+class ReplicationPrimary {
+public:
+    void addReplica(std::unique_ptr<Transport> t);
+
+    // Sequencer batch handler (see Sequencer::setBatchHandler).
+    void ship(uint64_t epoch, const std::vector<txn_ptr>& batch);
+
+    // Ends every stream; replicas finish once they apply what was shipped.
+    void close();
+
+    PrimaryStats stats() const;
+
+private:
+    std::vector<std::unique_ptr<Transport>> replicas_;
+    std::vector<char> msg_;
+    mutable std::mutex m_;
+    PrimaryStats stats_;
+};
+
+struct ReplicaOptions {
+    int workers = 1;
+    std::size_t maxQueueSize = 10000;
+    bool enable_sca = true;
+};
+
+struct ReplicaStats {
+    uint64_t epochs = 0;        // fully executed
+    uint64_t txns = 0;
+    uint64_t bytes = 0;
+    Transaction::id_t lastId = 0;
+    // Time from the primary sealing an epoch to its last transaction
+    // committing here.
+    double lagAvgMs = 0.0;
+    double lagMaxMs = 0.0;
+    bool corrupt = false;       // stopped at an undecodable message
+};
+
+// Executes a primary's epochs against its own store, which must start in
+// the primary's initial state, using `execute`, the primary's deterministic
+// transaction logic.
+class Replica {
+public:
+    Replica(::storageManager& store, std::unique_ptr<Transport> in,
+            std::function<void(txn_ptr)> execute, ReplicaOptions opts = {});
+    ~Replica();
+
+    Replica(const Replica&) = delete;
+    Replica& operator=(const Replica&) = delete;
+
+    void start();
+    // Returns once the stream has ended and everything received has run.
+    void wait();
+
+    ReplicaStats stats() const;
+
+private:
+    struct EpochProgress;
+    struct ReplicatedTxn;
+
+    void receiveLoop();
+    void onComplete(const txn_ptr& T);
+
+    ::storageManager& store_;
+    std::unique_ptr<Transport> in_;
+    std::function<void(txn_ptr)> execute_;
+    ReplicaOptions opts_;
+
+    TxnQueue queue_;
+    std::atomic<bool> streamEnded_{false};
+    std::thread receiver_;
+    std::vector<std::thread> workers_;
+
+    mutable std::mutex m_;
+    ReplicaStats stats_;
+    double lagSumMs_ = 0.0;
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "transport.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ConcVLL {
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+void write_all(int fd, const char* p, std::size_t n) {
+    while (n > 0) {
+        ssize_t w = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            throw_errno("replication send");
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+}
+
+// False on a clean end of stream before the first byte.
+bool read_all(int fd, char* p, std::size_t n) {
+    std::size_t got = 0;
+    while (got < n) {
+        ssize_t r = ::recv(fd, p + got, n - got, 0);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            throw_errno("replication recv");
+        }
+        if (r == 0) {
+            if (got == 0) return false;
+            throw std::system_error(EPIPE, std::generic_category(), "replication stream truncated");
+        }
+        got += static_cast<std::size_t>(r);
+    }
+    return true;
+}
+
+sockaddr_un unix_addr(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        throw std::system_error(ENAMETOOLONG, std::generic_category(), "socket path " + path);
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+}
+
+std::pair<std::unique_ptr<Transport>, std::unique_ptr<Transport>> InProcessTransport::pair() {
+    auto q = std::make_shared<Queue>();
+    return {std::unique_ptr<Transport>(new InProcessTransport(q)),
+            std::unique_ptr<Transport>(new InProcessTransport(q))};
+}
+
+void InProcessTransport::send(const std::vector<char>& msg) {
+    {
+        std::lock_guard<std::mutex> lg(q_->m);
+        q_->msgs.push_back(msg);
+    }
+    q_->cv.notify_one();
+}
+
+bool InProcessTransport::receive(std::vector<char>& msg) {
+    std::unique_lock<std::mutex> lk(q_->m);
+    q_->cv.wait(lk, [this]{ return !q_->msgs.empty() || q_->closed; });
+    if (q_->msgs.empty()) return false;
+    msg.swap(q_->msgs.front());
+    q_->msgs.pop_front();
+    return true;
+}
+
+void InProcessTransport::close() {
+    {
+        std::lock_guard<std::mutex> lg(q_->m);
+        q_->closed = true;
+    }
+    q_->cv.notify_all();
+}
+
+UnixSocketTransport::~UnixSocketTransport() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+std::pair<std::unique_ptr<Transport>, std::unique_ptr<Transport>> UnixSocketTransport::pair() {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) throw_errno("socketpair");
+    return {std::make_unique<UnixSocketTransport>(fds[0]), std::make_unique<UnixSocketTransport>(fds[1])};
+}
+
+std::unique_ptr<Transport> UnixSocketTransport::listen(const std::string& path) {
+    sockaddr_un addr = unix_addr(path);
+    int lfd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (lfd < 0) throw_errno("socket");
+    ::unlink(path.c_str());
+    if (::bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(lfd, 1) != 0) {
+        int err = errno;
+        ::close(lfd);
+        throw std::system_error(err, std::generic_category(), "listen " + path);
+    }
+    int fd = ::accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+    int err = errno;
+    ::close(lfd);
+    ::unlink(path.c_str());
+    if (fd < 0) throw std::system_error(err, std::generic_category(), "accept " + path);
+    return std::make_unique<UnixSocketTransport>(fd);
+}
+
+std::unique_ptr<Transport> UnixSocketTransport::connect(const std::string& path) {
+    sockaddr_un addr = unix_addr(path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) throw_errno("socket");
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "connect " + path);
+    }
+    return std::make_unique<UnixSocketTransport>(fd);
+}
+
+void UnixSocketTransport::send(const std::vector<char>& msg) {
+    uint32_t len = static_cast<uint32_t>(msg.size());
+    write_all(fd_, reinterpret_cast<const char*>(&len), sizeof(len));
+    write_all(fd_, msg.data(), msg.size());
+}
+
+bool UnixSocketTransport::receive(std::vector<char>& msg) {
+    uint32_t len;
+    if (!read_all(fd_, reinterpret_cast<char*>(&len), sizeof(len))) return false;
+    msg.resize(len);
+    if (len && !read_all(fd_, msg.data(), len))
+        throw std::system_error(EPIPE, std::generic_category(), "replication stream truncated");
+    return true;
+}
+
+void UnixSocketTransport::close() {
+    ::shutdown(fd_, SHUT_WR);
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ConcVLL {
+
+// One direction of a message stream between a primary and a replica.
+// Messages arrive whole and in order.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual void send(const std::vector<char>& msg) = 0;
+    // Blocks for the next message. Returns false once the sending side has
+    // closed and every message sent before has been received.
+    virtual bool receive(std::vector<char>& msg) = 0;
+    // Sending side: no more messages.
+    virtual void close() = 0;
+};
+
+// Both ends share one in-memory queue. Sends never block.
+class InProcessTransport : public Transport {
+public:
+    // Sender and receiver ends of a new stream.
+    static std::pair<std::unique_ptr<Transport>, std::unique_ptr<Transport>> pair();
+
+    void send(const std::vector<char>& msg) override;
+    bool receive(std::vector<char>& msg) override;
+    void close() override;
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::condition_variable cv;
+        std::deque<std::vector<char>> msgs;
+        bool closed = false;
+    };
+
+    explicit InProcessTransport(std::shared_ptr<Queue> q) : q_(std::move(q)) {}
+
+    std::shared_ptr<Queue> q_;
+};
+
+// Stream socket carrying u32 length-prefixed messages. Throws
+// std::system_error if the socket fails.
+class UnixSocketTransport : public Transport {
+public:
+    explicit UnixSocketTransport(int fd) : fd_(fd) {}
+    ~UnixSocketTransport() override;
+
+    UnixSocketTransport(const UnixSocketTransport&) = delete;
+    UnixSocketTransport& operator=(const UnixSocketTransport&) = delete;
+
+    // Connected ends over socketpair(2).
+    static std::pair<std::unique_ptr<Transport>, std::unique_ptr<Transport>> pair();
+    // For replicas in another process: the replica listens on path and
+    // accepts one primary, which connects.
+    static std::unique_ptr<Transport> listen(const std::string& path);
+    static std::unique_ptr<Transport> connect(const std::string& path);
+
+    void send(const std::vector<char>& msg) override;
+    bool receive(std::vector<char>& msg) override;
+    void close() override;
+
+private:
+    int fd_;
+};
+
+}
+
+#endif
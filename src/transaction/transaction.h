@@ -2,9 +2,13 @@
 #define TRANSACTION_H
 
 #include <cstdint>
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "../core/record.h"
 
 namespace ConcVLL {
 
@@ -14,22 +18,64 @@ enum class TxnStatus : uint8_t {
     Aborted
 };
 
+// Inclusive key range read by a scan.
+struct KeyRange {
+    std::string lo;
+    std::string hi;
+
+    bool contains(std::string_view k) const { return k >= lo && k <= hi; }
+};
+
+// A commutative update naming its key by value, for building transactions.
+struct UpdateSpec {
+    std::string key;
+    UpdateOp op;
+    int64_t operand;
+};
+
 struct Transaction {
     using id_t = uint64_t;
 
     id_t id;
     TxnStatus status;
+    uint64_t lsn = 0;   // command log position, 0 when not logged
+    // Set for read-only transactions run against a snapshot of a versioned
+    // store instead of through the queue; reads go through readAt(readTs).
+    bool snapshotRead = false;
+    uint64_t readTs = 0;
 
     Transaction() : id(0), status(TxnStatus::Active) {}
 
     explicit Transaction(id_t i) : id(i), status(TxnStatus::Active) {}
 
-    std::vector<std::string> ReadSet;
-    std::vector<std::string> WriteSet;
+    // Keys are views, hashed once when the sets are filled. Their bytes live
+    // in keyOwner (a pinned receive buffer, or the copy made by assignKeys)
+    // or in storage that outlives the txn.
+    std::vector<KeyHandle> ReadSet;
+    std::vector<KeyHandle> WriteSet;
+    // Commutative updates, sorted by key with one entry per key. They hold
+    // a key against readers, writers and updates with another operation.
+    std::vector<CommutativeUpdate> UpdateSet;
+    std::vector<KeyRange> ReadRanges;
+    std::shared_ptr<const void> keyOwner;
+
+    // Records of ReadSet, WriteSet and UpdateSet, in the same order, looked
+    // up under the queue mutex at admission. Executing and finishing the
+    // transaction use these rather than hashing into a store that later
+    // admissions may be inserting into. Empty when the txn was not admitted
+    // through a TxnQueue.
+    std::vector<tuple*> ReadRecords;
+    std::vector<tuple*> WriteRecords;
+    std::vector<tuple*> UpdateRecords;
+
+    // Keys that were in ReadRanges at admission, for SCA. They point into
+    // the store, which never reclaims key bytes.
+    std::vector<std::string_view> RangeKeys;
 
     // Hashed keys for SCA
     std::vector<std::size_t> hashedReadSet;
     std::vector<std::size_t> hashedWriteSet;
+    std::vector<std::size_t> hashedUpdateSet;
     bool hashes_cached = false;
 
     enum class Type : uint8_t { Free = 0, Blocked };
@@ -42,6 +88,65 @@ struct Transaction {
     Transaction(Transaction&&) = default;
     Transaction& operator=(Transaction&&) = default;
 
+    // Copies the keys into one buffer owned by the transaction. Throws
+    // std::invalid_argument if two updates of one key use different
+    // operations.
+    void assignKeys(const std::vector<std::string>& reads, const std::vector<std::string>& writes,
+                    const std::vector<UpdateSpec>& updates = {}) {
+        std::size_t bytes = 0;
+        for (const auto& k : reads) bytes += k.size();
+        for (const auto& k : writes) bytes += k.size();
+        for (const auto& u : updates) bytes += u.key.size();
+        std::shared_ptr<char[]> buf(new char[bytes ? bytes : 1]);
+        char* p = buf.get();
+        auto copy = [&p](const std::vector<std::string>& keys, std::vector<KeyHandle>& out) {
+            out.clear();
+            out.reserve(keys.size());
+            for (const auto& k : keys) {
+                k.copy(p, k.size());
+                out.emplace_back(std::string_view(p, k.size()));
+                p += k.size();
+            }
+        };
+        copy(reads, ReadSet);
+        copy(writes, WriteSet);
+        std::vector<CommutativeUpdate> ups;
+        ups.reserve(updates.size());
+        for (const auto& u : updates) {
+            u.key.copy(p, u.key.size());
+            ups.push_back(CommutativeUpdate{KeyHandle(std::string_view(p, u.key.size())), u.op, u.operand});
+            p += u.key.size();
+        }
+        setUpdates(std::move(ups));
+        keyOwner = std::move(buf);
+    }
+
+    // Hashes keys whose bytes the caller keeps alive (see keyOwner).
+    void setKeys(const std::vector<std::string_view>& reads, const std::vector<std::string_view>& writes) {
+        ReadSet.assign(reads.begin(), reads.end());
+        WriteSet.assign(writes.begin(), writes.end());
+    }
+
+    // Sorts updates by key and folds repeated keys into one update (sum for
+    // Add, the extreme for Min/Max). Throws std::invalid_argument if one key
+    // is given two operations.
+    void setUpdates(std::vector<CommutativeUpdate> updates) {
+        std::sort(updates.begin(), updates.end(),
+                  [](const CommutativeUpdate& a, const CommutativeUpdate& b){ return a.key < b.key; });
+        UpdateSet.clear();
+        for (auto& u : updates) {
+            if (UpdateSet.empty() || UpdateSet.back().key != u.key) {
+                UpdateSet.push_back(u);
+                continue;
+            }
+            auto& prev = UpdateSet.back();
+            if (prev.op != u.op) throw std::invalid_argument("conflicting updates of one key");
+            if (u.op == UpdateOp::Add) prev.operand += u.operand;
+            else if (u.op == UpdateOp::Min) prev.operand = std::min(prev.operand, u.operand);
+            else prev.operand = std::max(prev.operand, u.operand);
+        }
+    }
+
     bool isActive() const noexcept { return status == TxnStatus::Active; }
     bool isCommitted() const noexcept { return status == TxnStatus::Committed; }
     bool isAborted() const noexcept { return status == TxnStatus::Aborted; }
@@ -0,0 +1,179 @@
+#include "test_util.h"
+#include "workload.h"
+#include "core/checkpoint.h"
+#include "core/vll_stman.h"
+#include "durability/command_log.h"
+#include "durability/recovery.h"
+
+#include <cstring>
+#include <future>
+#include <stdexcept>
+
+namespace {
+
+void fill(storageManager& store) {
+    for (int i = 0; i < 100; ++i) {
+        std::string k = "key" + std::to_string(i);
+        store.insert(k, std::string(static_cast<std::size_t>(i % 40), 'a' + i % 26));
+        store.update(store.get(k), UpdateOp::Add, i, 0);
+    }
+}
+
+bool loadFails(const std::string& path) {
+    storageManager store;
+    try {
+        Checkpoint::load(store, path);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+}
+
+TEST(checkpoint, write_then_load) {
+    Testing::TempPath path("ckpt");
+    storageManager src;
+    fill(src);
+    CheckpointInfo w = Checkpoint::write(src, path.str(), 42);
+    CHECK(w.records == 100);
+
+    storageManager dst;
+    CheckpointInfo l = Checkpoint::load(dst, path.str());
+    CHECK(l.records == 100);
+    CHECK(l.boundaryId == 42);
+    CHECK(dst.checksum() == src.checksum());
+    tuple* t = dst.get(std::string_view("key7"));
+    REQUIRE(t);
+    CHECK(t->value.view() == std::string(7, 'h'));
+    CHECK(t->num.load() == 7);
+}
+
+TEST(checkpoint, rejects_damaged_files) {
+    Testing::TempPath path("ckpt");
+    storageManager src;
+    fill(src);
+    Checkpoint::write(src, path.str());
+    std::string bytes = Testing::readFile(path.str());
+
+    Testing::writeFile(path.str(), bytes.substr(0, bytes.size() / 2));
+    CHECK(loadFails(path.str()));
+
+    std::string bad = bytes;
+    bad[0] = 'X';
+    Testing::writeFile(path.str(), bad);
+    CHECK(loadFails(path.str()));
+
+    // Point the last entry's value past the end of the file.
+    bad = bytes;
+    uint64_t huge = bytes.size();
+    std::size_t last = bytes.size() - sizeof(Checkpoint::Entry);
+    std::memcpy(&bad[last + offsetof(Checkpoint::Entry, valueOffset)], &huge, sizeof(huge));
+    Testing::writeFile(path.str(), bad);
+    CHECK(loadFails(path.str()));
+}
+
+TEST(checkpoint, background_keeps_pre_images) {
+    Testing::TempPath path("ckpt");
+    storageManager store;
+    fill(store);
+    uint64_t before = store.checksum();
+
+    std::promise<void> drained;
+    BackgroundCheckpoint ckpt(store, path.str());
+    ckpt.begin(10);
+    ckpt.run([f = drained.get_future().share()]{ f.wait(); });
+
+    // Writers past the boundary run before the scan starts; the checkpoint
+    // must still see the values as of the boundary.
+    tuple* t = store.get(std::string_view("key3"));
+    store.write(t, "changed after the boundary", 11);
+    store.update(t, UpdateOp::Add, 1000, 11);
+    store.write(store.get(std::string_view("key50")), "", 12);
+    drained.set_value();
+    CheckpointInfo info = ckpt.wait();
+    CHECK(info.records == 100);
+    CHECK(info.preserved >= 2);
+
+    storageManager loaded;
+    Checkpoint::load(loaded, path.str());
+    CHECK(loaded.checksum() == before);
+    tuple* l = loaded.get(std::string_view("key3"));
+    REQUIRE(l);
+    CHECK(l->value.view() == std::string(3, 'd'));
+    CHECK(l->num.load() == 3);
+    CHECK(store.get(std::string_view("key3"))->num.load() == 1003);
+}
+
+TEST(checkpoint, background_skips_keys_created_after_begin) {
+    Testing::TempPath path("ckpt");
+    storageManager store;
+    fill(store);
+    uint64_t before = store.checksum();
+
+    std::promise<void> drained;
+    BackgroundCheckpoint ckpt(store, path.str());
+    ckpt.begin(10);
+    ckpt.run([f = drained.get_future().share()]{ f.wait(); });
+
+    // Inserts are ordered after the boundary, like the admissions of the
+    // transactions past it that create keys.
+    for (int i = 0; i < 50; ++i) {
+        std::string k = "late" + std::to_string(i);
+        store.insert(k, "new");
+    }
+    store.write(store.get(std::string_view("late7")), "written after the boundary", 11);
+    store.insert(std::string_view("key5"), "overwritten after the boundary");
+    drained.set_value();
+    CheckpointInfo info = ckpt.wait();
+    CHECK(info.records == 100);
+
+    storageManager loaded;
+    Checkpoint::load(loaded, path.str());
+    CHECK(loaded.size() == 100);
+    CHECK(loaded.checksum() == before);
+    CHECK(loaded.get(std::string_view("late7")) == nullptr);
+    CHECK(store.size() == 150);
+}
+
+TEST(checkpoint, background_keeps_older_updates_that_finish_late) {
+    Testing::TempPath ckptPath("ckpt");
+    Testing::TempPath logPath("log");
+    storageManager store;
+    store.insert(std::string_view("counter"), "");
+
+    auto add = [](ConcVLL::Transaction::id_t id, int64_t n) {
+        auto T = std::make_shared<ConcVLL::Transaction>(id);
+        T->assignKeys({}, {}, {ConcVLL::UpdateSpec{"counter", UpdateOp::Add, n}});
+        return T;
+    };
+    auto older = add(1, 1);
+    auto newer = add(2, 10);
+    {
+        ConcVLL::CommandLog log(logPath.str());
+        log.append(*older);
+        log.append(*newer);
+    }
+
+    std::promise<void> drained;
+    BackgroundCheckpoint ckpt(store, ckptPath.str());
+    ckpt.begin(older->id);
+    ckpt.run([f = drained.get_future().share()]{ f.wait(); });
+    // Both hold the counter's Add lock, so the newer one can run first and
+    // preserve the counter before the older one has added to it.
+    Testing::apply(store, *newer);
+    Testing::apply(store, *older);
+    drained.set_value();
+    CheckpointInfo info = ckpt.wait();
+
+    storageManager recovered;
+    Checkpoint::load(recovered, ckptPath.str());
+    CHECK(recovered.get(std::string_view("counter"))->num.load() == 1);
+    ConcVLL::RecoveryOptions ro;
+    ro.startAfterId = info.boundaryId;
+    ConcVLL::RecoveryStats rs = ConcVLL::ReplayCommandLog(logPath.str(), recovered,
+        [&](ConcVLL::txn_ptr T){ Testing::apply(recovered, *T); }, ro);
+    CHECK(rs.replayed == 1);
+    CHECK(recovered.get(std::string_view("counter"))->num.load() == 11);
+    CHECK(recovered.checksum() == store.checksum());
+}
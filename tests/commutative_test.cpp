@@ -0,0 +1,98 @@
+#include "test_util.h"
+#include "concurrency/lock_manager_2pl.h"
+#include "concurrency/vll.h"
+#include "core/vll_stman.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace ConcVLL;
+
+namespace {
+
+txn_ptr txn(std::vector<std::string> reads, std::vector<std::string> writes, std::vector<UpdateSpec> updates = {}) {
+    auto T = std::make_shared<Transaction>(0);
+    T->assignKeys(reads, writes, updates);
+    return T;
+}
+
+txn_ptr add(int64_t n) { return txn({}, {}, {UpdateSpec{"hot", UpdateOp::Add, n}}); }
+
+void runAll(TxnQueue& q, storageManager& store, const std::vector<txn_ptr>& free) {
+    auto apply = [&](const txn_ptr& T){
+        for (const auto& u : T->UpdateSet) store.update(store.get(u.key), u.op, u.operand, T->id);
+    };
+    for (const auto& T : free) {
+        apply(T);
+        q.FinishTransaction(T, store);
+    }
+    q.VLLMainLoop(store, apply, []{ return txn_ptr(); }, []{ return true; });
+}
+
+}
+
+TEST(commutative, same_op_updates_share_a_key) {
+    storageManager store;
+    store.insert(std::string_view("hot"), "");
+    TxnQueue q;
+
+    auto a = add(5), b = add(7);
+    CHECK(q.BeginTransaction(a, store));
+    CHECK(q.BeginTransaction(b, store));
+    auto min = txn({}, {}, {UpdateSpec{"hot", UpdateOp::Min, -1}});
+    auto reader = txn({"hot"}, {});
+    auto c = add(1);
+    CHECK(!q.BeginTransaction(min, store));
+    CHECK(!q.BeginTransaction(reader, store));
+    // Behind a blocked reader an update must wait too, or it would overtake it.
+    CHECK(!q.BeginTransaction(c, store));
+
+    runAll(q, store, {a, b});
+    CHECK(q.activeCount() == 0);
+    CHECK(store.get(std::string_view("hot"))->num.load() == -1 + 1);
+}
+
+TEST(commutative, update_waits_for_older_writer) {
+    storageManager store;
+    store.insert(std::string_view("hot"), "");
+    TxnQueue q;
+
+    auto w = txn({}, {"hot"});
+    auto u = add(3);
+    CHECK(q.BeginTransaction(w, store));
+    CHECK(!q.BeginTransaction(u, store));
+    runAll(q, store, {w});
+    CHECK(store.get(std::string_view("hot"))->num.load() == 3);
+}
+
+TEST(commutative, two_phase_locking_agrees) {
+    LockManager2PL locks;
+    std::vector<KeyHandle> none;
+    std::vector<CommutativeUpdate> addHot{CommutativeUpdate{KeyHandle(std::string_view("hot")), UpdateOp::Add, 1}};
+    std::vector<CommutativeUpdate> minHot{CommutativeUpdate{KeyHandle(std::string_view("hot")), UpdateOp::Min, 1}};
+
+    // Two Add locks on one key are granted together, from one thread.
+    locks.acquire_all_atomically(none, none, addHot);
+    locks.acquire_all_atomically(none, none, addHot);
+    CHECK(locks.counters().waits == 0);
+
+    // A Min update and a writer wait until both Adds are released.
+    std::atomic<int> granted{0};
+    std::vector<KeyHandle> hot{KeyHandle(std::string_view("hot"))};
+    std::thread other([&]{
+        locks.acquire_all_atomically(none, none, minHot);
+        granted.fetch_add(1);
+        locks.release_all(none, none, minHot);
+        locks.acquire_all_atomically(none, hot);
+        granted.fetch_add(1);
+        locks.release_all(none, hot);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(granted.load() == 0);
+    locks.release_all(none, none, addHot);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(granted.load() == 0);
+    locks.release_all(none, none, addHot);
+    other.join();
+    CHECK(granted.load() == 2);
+}
@@ -0,0 +1,88 @@
+#include "test_util.h"
+#include "workload.h"
+#include "concurrency/hybrid.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace ConcVLL;
+
+namespace {
+
+constexpr int kKeys = 16;
+constexpr int kTxns = 4000;
+
+// Switches after every window.
+class AlternatingPolicy : public ModePolicy {
+public:
+    CCMode decide(const ModeWindow& w) override {
+        return w.mode == CCMode::VLL ? CCMode::TwoPL : CCMode::VLL;
+    }
+    const char* name() const override { return "alternating"; }
+};
+
+}
+
+TEST(hybrid, switches_under_load_keep_modes_apart) {
+    storageManager store;
+    Testing::preload(store, kKeys);
+    HybridOptions opts;
+    opts.window = std::chrono::milliseconds(2);
+    HybridEngine engine(store, std::make_shared<AlternatingPolicy>(), opts);
+
+    std::atomic<int> running[2] = {{0}, {0}};
+    std::atomic<bool> overlap{false};
+    std::atomic<int> ranIn[2] = {{0}, {0}};
+    std::mutex orderMtx;
+    std::vector<txn_ptr> order;     // commit order, for the serial run
+
+    auto execute = [&](txn_ptr T){
+        // Only VLL admission marks a transaction free; 2PL never admits it.
+        int m = static_cast<int>(T->type == Transaction::Type::Free ? CCMode::VLL : CCMode::TwoPL);
+        running[m].fetch_add(1);
+        if (static_cast<int>(engine.mode()) != m) overlap = true;
+        if (running[1 - m].load() != 0) overlap = true;
+        Testing::apply(store, *T);
+        {
+            std::lock_guard<std::mutex> lg(orderMtx);
+            order.push_back(T);
+        }
+        if (T->id % 64 == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        if (running[1 - m].load() != 0) overlap = true;
+        ranIn[m].fetch_add(1);
+        running[m].fetch_sub(1);
+    };
+
+    Testing::Feed feed(kTxns, kKeys);
+    engine.start();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 3; ++i) {
+        workers.emplace_back([&]{
+            engine.workerLoop(execute, [&]{ return feed.next(); }, [&]{ return feed.exhausted(); });
+        });
+    }
+    for (auto& t : workers) t.join();
+    engine.stop();
+
+    CHECK(!overlap);
+    CHECK(engine.stats().switches >= 2);
+    CHECK(ranIn[0].load() > 0 && ranIn[1].load() > 0);
+
+    // Ids continue across switches: every transaction got one, none twice.
+    REQUIRE(order.size() == std::size_t(kTxns));
+    std::vector<Transaction::id_t> ids;
+    for (const auto& T : order) ids.push_back(T->id);
+    std::sort(ids.begin(), ids.end());
+    bool contiguous = true;
+    for (std::size_t i = 0; i < ids.size(); ++i) contiguous = contiguous && ids[i] == i + 1;
+    CHECK(contiguous);
+
+    // Re-running the transactions one at a time in commit order gives the
+    // same store.
+    storageManager serial;
+    Testing::preload(serial, kKeys);
+    for (const auto& T : order) Testing::apply(serial, *T);
+    CHECK(serial.checksum() == store.checksum());
+}
@@ -0,0 +1,80 @@
+#include "test_util.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+namespace Testing {
+
+namespace {
+int failures = 0;
+}
+
+std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+bool add(const char* suite, const char* name, void (*fn)()) {
+    registry().push_back(Case{suite, name, fn});
+    return true;
+}
+
+void fail(const char* file, int line, const char* expr) {
+    ++failures;
+    std::cerr << file << ':' << line << ": CHECK failed: " << expr << '\n';
+}
+
+TempPath::TempPath(const std::string& tag) {
+    static std::atomic<int> seq{0};
+    const char* dir = std::getenv("TMPDIR");
+    path_ = std::string(dir && *dir ? dir : "/tmp") + "/vll_tests_" + std::to_string(::getpid()) + "_" +
+            std::to_string(seq.fetch_add(1)) + "_" + tag;
+}
+
+TempPath::~TempPath() {
+    std::remove(path_.c_str());
+    std::remove((path_ + ".tmp").c_str());
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+void writeFile(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+}
+
+// Usage: vll_tests [suite]. Runs every test, or those of one suite, and
+// exits non-zero if any check failed.
+int main(int argc, char** argv) {
+    const char* only = argc > 1 ? argv[1] : nullptr;
+    int ran = 0;
+    int failedTests = 0;
+    for (const auto& c : Testing::registry()) {
+        if (only && std::strcmp(only, c.suite) != 0) continue;
+        int before = Testing::failures;
+        c.fn();
+        ++ran;
+        bool ok = Testing::failures == before;
+        if (!ok) ++failedTests;
+        std::cout << (ok ? "[ OK ] " : "[FAIL] ") << c.suite << '.' << c.name << '\n';
+    }
+    if (ran == 0) {
+        std::cerr << "no tests" << (only ? std::string(" in suite ") + only : std::string()) << '\n';
+        return 1;
+    }
+    std::cout << ran << " tests, " << failedTests << " failed\n";
+    return failedTests ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+#include "test_util.h"
+#include "workload.h"
+#include "concurrency/vll.h"
+#include "durability/command_log.h"
+#include "durability/recovery.h"
+
+#include <thread>
+
+using namespace ConcVLL;
+
+namespace {
+
+constexpr int kKeys = 16;
+constexpr int kTxns = 2000;
+
+// Runs the workload through a logging TxnQueue on a few workers; returns
+// the store's checksum.
+uint64_t runLogged(const std::string& logPath) {
+    storageManager store;
+    Testing::preload(store, kKeys);
+    TxnQueue q;
+    CommandLog log(logPath);
+    q.setCommandLog(&log);
+    Testing::Feed feed(kTxns, kKeys);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 3; ++i) {
+        workers.emplace_back([&]{
+            q.VLLMainLoop(store,
+                [&](txn_ptr T){ Testing::apply(store, *T); },
+                [&]{ return feed.next(); },
+                [&]{ return feed.exhausted(); },
+                64);
+        });
+    }
+    for (auto& t : workers) t.join();
+    return store.checksum();
+}
+
+RecoveryStats replay(const std::string& logPath, storageManager& store) {
+    Testing::preload(store, kKeys);
+    RecoveryOptions opts;
+    opts.numThreads = 3;
+    return ReplayCommandLog(logPath, store, [&](txn_ptr T){ Testing::apply(store, *T); }, opts);
+}
+
+}
+
+TEST(recovery, replay_matches_primary) {
+    Testing::TempPath path("log");
+    uint64_t primary = runLogged(path.str());
+
+    storageManager store;
+    RecoveryStats st = replay(path.str(), store);
+    CHECK(st.replayed == kTxns);
+    CHECK(st.maxId == kTxns);
+    CHECK(!st.truncatedTail);
+    CHECK(store.checksum() == primary);
+}
+
+TEST(recovery, torn_tail_drops_last_record) {
+    Testing::TempPath path("log");
+    runLogged(path.str());
+    std::string bytes = Testing::readFile(path.str());
+    Testing::writeFile(path.str(), bytes.substr(0, bytes.size() - 2));
+
+    storageManager store;
+    RecoveryStats st = replay(path.str(), store);
+    CHECK(st.truncatedTail);
+    CHECK(st.replayed == kTxns - 1);
+    CHECK(st.maxId == kTxns - 1);
+}
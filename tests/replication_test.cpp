@@ -0,0 +1,83 @@
+#include "test_util.h"
+#include "workload.h"
+#include "concurrency/sequencer.h"
+#include "concurrency/vll.h"
+#include "replication/replication.h"
+#include "replication/transport.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace ConcVLL;
+
+namespace {
+
+constexpr int kKeys = 16;
+constexpr int kTxns = 3000;
+
+// Sequences the workload on a primary that ships every epoch to one replica
+// per transport; returns the primary's checksum once everything ran.
+uint64_t runPrimary(std::vector<std::unique_ptr<Transport>> transports) {
+    storageManager store;
+    Testing::preload(store, kKeys);
+    TxnQueue q;
+    ReplicationPrimary primary;
+    for (auto& t : transports) primary.addReplica(std::move(t));
+
+    SequencerOptions so;
+    so.epoch = std::chrono::microseconds(500);
+    so.maxQueueSize = 256;
+    Sequencer seq(q, store, so);
+    seq.setBatchHandler([&](uint64_t epoch, const std::vector<txn_ptr>& b){ primary.ship(epoch, b); });
+    seq.start();
+
+    std::atomic<bool> sealed{false};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 2; ++i) {
+        workers.emplace_back([&]{
+            q.VLLMainLoop(store,
+                [&](txn_ptr T){ Testing::apply(store, *T); },
+                []{ return txn_ptr(); },
+                [&]{ return sealed.load(); });
+        });
+    }
+    for (int i = 0; i < kTxns; ++i) seq.submit(Testing::makeTxn(i, kKeys));
+    seq.stop();
+    sealed = true;
+    for (auto& t : workers) t.join();
+    primary.close();
+    return store.checksum();
+}
+
+}
+
+TEST(replication, replicas_match_primary) {
+    auto inProc = InProcessTransport::pair();
+    auto socket = UnixSocketTransport::pair();
+
+    storageManager s1, s2;
+    Testing::preload(s1, kKeys);
+    Testing::preload(s2, kKeys);
+    ReplicaOptions ro;
+    ro.workers = 2;
+    Replica r1(s1, std::move(inProc.second), [&](txn_ptr T){ Testing::apply(s1, *T); }, ro);
+    Replica r2(s2, std::move(socket.second), [&](txn_ptr T){ Testing::apply(s2, *T); }, ro);
+    r1.start();
+    r2.start();
+
+    std::vector<std::unique_ptr<Transport>> ends;
+    ends.push_back(std::move(inProc.first));
+    ends.push_back(std::move(socket.first));
+    uint64_t primary = runPrimary(std::move(ends));
+    r1.wait();
+    r2.wait();
+
+    for (const Replica* r : {&r1, &r2}) {
+        ReplicaStats st = r->stats();
+        CHECK(!st.corrupt);
+        CHECK(st.txns == kTxns);
+        CHECK(st.lastId == kTxns);
+    }
+    CHECK(s1.checksum() == primary);
+    CHECK(s2.checksum() == primary);
+}
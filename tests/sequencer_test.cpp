@@ -0,0 +1,156 @@
+#include "test_util.h"
+#include "workload.h"
+#include "concurrency/sequencer.h"
+#include "concurrency/vll.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace ConcVLL;
+
+namespace {
+
+constexpr int kKeys = 16;
+constexpr int kTxns = 2000;
+
+uint64_t serialChecksum() {
+    storageManager store;
+    Testing::preload(store, kKeys);
+    for (int i = 0; i < kTxns; ++i) {
+        txn_ptr T = Testing::makeTxn(i, kKeys);
+        T->id = static_cast<Transaction::id_t>(i + 1);
+        Testing::apply(store, *T);
+    }
+    return store.checksum();
+}
+
+}
+
+TEST(sequencer, ids_follow_submission_order) {
+    storageManager store;
+    Testing::preload(store, kKeys);
+    TxnQueue q;
+    SequencerOptions so;
+    so.epoch = std::chrono::microseconds(200);
+    Sequencer seq(q, store, so);
+    seq.start();
+
+    std::atomic<bool> sealed{false};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 2; ++i) {
+        workers.emplace_back([&]{
+            q.VLLMainLoop(store,
+                [&](txn_ptr T){ Testing::apply(store, *T); },
+                []{ return txn_ptr(); },
+                [&]{ return sealed.load(); });
+        });
+    }
+    std::vector<txn_ptr> submitted;
+    for (int i = 0; i < kTxns; ++i) {
+        submitted.push_back(Testing::makeTxn(i, kKeys));
+        seq.submit(submitted.back());
+        if (i % 300 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    seq.stop();
+    sealed = true;
+    for (auto& t : workers) t.join();
+
+    bool ordered = true;
+    for (int i = 0; i < kTxns; ++i) ordered = ordered && submitted[i]->id == Transaction::id_t(i + 1);
+    CHECK(ordered);
+    SequencerStats st = seq.stats();
+    CHECK(st.txns == kTxns);
+    CHECK(st.epochs > 1);
+    CHECK(q.activeCount() == 0);
+    // Executing an epoch is equivalent to running it in id order.
+    CHECK(store.checksum() == serialChecksum());
+}
+
+TEST(sequencer, batch_handler_sees_admitted_epochs_in_order) {
+    storageManager store;
+    Testing::preload(store, kKeys);
+    TxnQueue q;
+    SequencerOptions so;
+    so.epoch = std::chrono::microseconds(200);
+    Sequencer seq(q, store, so);
+
+    uint64_t lastEpoch = 0;
+    Transaction::id_t lastId = 0;
+    bool inOrder = true;
+    bool admitted = true;
+    std::size_t handled = 0;
+    seq.setBatchHandler([&](uint64_t epoch, const std::vector<txn_ptr>& batch){
+        inOrder = inOrder && epoch == lastEpoch + 1;
+        lastEpoch = epoch;
+        for (const auto& T : batch) {
+            // Ids are set by BeginBatch, so they are there and contiguous.
+            admitted = admitted && T->id == lastId + 1;
+            lastId = T->id;
+        }
+        handled += batch.size();
+    });
+    seq.start();
+
+    std::atomic<bool> sealed{false};
+    std::thread worker([&]{
+        q.VLLMainLoop(store,
+            [&](txn_ptr T){ Testing::apply(store, *T); },
+            []{ return txn_ptr(); },
+            [&]{ return sealed.load(); });
+    });
+    for (int i = 0; i < kTxns; ++i) {
+        seq.submit(Testing::makeTxn(i, kKeys));
+        if (i % 300 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    seq.stop();
+    sealed = true;
+    worker.join();
+
+    CHECK(inOrder);
+    CHECK(admitted);
+    CHECK(handled == kTxns);
+    CHECK(lastEpoch == seq.stats().epochs);
+    CHECK(lastEpoch > 1);
+}
+
+TEST(sequencer, submit_blocks_on_a_full_backlog) {
+    storageManager store;
+    Testing::preload(store, kKeys);
+    TxnQueue q;
+    SequencerOptions so;
+    so.epoch = std::chrono::microseconds(200);
+    so.maxQueueSize = 4;
+    Sequencer seq(q, store, so);
+
+    // Not started yet, so nothing drains the backlog.
+    std::atomic<int> submitted{0};
+    std::thread producer([&]{
+        for (int i = 0; i < 20; ++i) {
+            seq.submit(Testing::makeTxn(i, kKeys));
+            submitted.fetch_add(1);
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(submitted.load() == 4);
+
+    // Epochs are also held back while the queue is full, so the queue
+    // stays within one epoch of the limit.
+    seq.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(q.activeCount() <= 2 * so.maxQueueSize);
+    CHECK(submitted.load() < 20);
+
+    std::atomic<bool> sealed{false};
+    std::thread worker([&]{
+        q.VLLMainLoop(store,
+            [&](txn_ptr T){ Testing::apply(store, *T); },
+            []{ return txn_ptr(); },
+            [&]{ return sealed.load(); });
+    });
+    producer.join();
+    seq.stop();
+    sealed = true;
+    worker.join();
+    CHECK(submitted.load() == 20);
+    CHECK(seq.stats().txns == 20);
+}
@@ -0,0 +1,50 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <string>
+#include <vector>
+
+// Minimal assertion-based tests, run by vll_tests. CHECK records a failure
+// and carries on; REQUIRE also leaves the test.
+namespace Testing {
+
+struct Case {
+    const char* suite;
+    const char* name;
+    void (*fn)();
+};
+
+std::vector<Case>& registry();
+bool add(const char* suite, const char* name, void (*fn)());
+void fail(const char* file, int line, const char* expr);
+
+// A fresh path in the temp directory. The file, and "<path>.tmp", are
+// removed when it goes out of scope.
+class TempPath {
+public:
+    explicit TempPath(const std::string& tag);
+    ~TempPath();
+
+    TempPath(const TempPath&) = delete;
+    TempPath& operator=(const TempPath&) = delete;
+
+    const std::string& str() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+std::string readFile(const std::string& path);
+void writeFile(const std::string& path, const std::string& bytes);
+
+}
+
+#define TEST(suite, name)                                                           \
+    static void suite##_##name();                                                   \
+    static const bool suite##_##name##_added = Testing::add(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(cond) do { if (!(cond)) Testing::fail(__FILE__, __LINE__, #cond); } while (0)
+#define REQUIRE(cond) do { if (!(cond)) { Testing::fail(__FILE__, __LINE__, #cond); return; } } while (0)
+
+#endif
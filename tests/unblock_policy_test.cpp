@@ -0,0 +1,64 @@
+#include "test_util.h"
+#include "concurrency/unblock_policy.h"
+
+using namespace ConcVLL;
+
+namespace {
+
+UnblockMetrics metrics(std::size_t queued, std::size_t blocked, std::size_t max = 1024) {
+    UnblockMetrics m;
+    m.queueSize = queued;
+    m.blockedCount = blocked;
+    m.maxQueueSize = max;
+    m.workers = 4;
+    return m;
+}
+
+}
+
+TEST(unblock_policy, queue_full_follows_the_paper) {
+    QueueFullPolicy sca(true), nosca(false);
+    CHECK(sca.decide(metrics(0, 0)).action == UnblockAction::None);
+    CHECK(sca.decide(metrics(10, 5)).action == UnblockAction::ScanOlder);
+    CHECK(sca.decide(metrics(1024, 5)).action == UnblockAction::SCA);
+    CHECK(sca.decide(metrics(1024, 5)).scanDepth == 0);
+    CHECK(nosca.decide(metrics(1024, 5)).action == UnblockAction::Head);
+}
+
+TEST(unblock_policy, adaptive_triggers_sca_on_blocked_ratio) {
+    AdaptivePolicy p;
+    CHECK(p.decide(metrics(0, 0)).action == UnblockAction::None);
+    CHECK(p.decide(metrics(500, 0)).action == UnblockAction::None);
+
+    // A quarter blocked: SCA over the whole queue while it keeps hitting.
+    UnblockMetrics m = metrics(1000, 250);
+    UnblockDecision d = p.decide(m);
+    CHECK(d.action == UnblockAction::SCA);
+    CHECK(d.scanDepth == 0);
+
+    // Missing every time, with no idle workers: only the minimum prefix.
+    m.scaHitRate = 0.0;
+    d = p.decide(m);
+    CHECK(d.action == UnblockAction::SCA);
+    CHECK(d.scanDepth == 64);
+
+    // Idle workers on a full queue trigger SCA below the ratio as well.
+    m = metrics(1024, 10);
+    m.idleWorkers = 4;
+    m.scaHitRate = 0.0;
+    CHECK(p.decide(m).action == UnblockAction::SCA);
+    CHECK(p.decide(m).scanDepth == 0);
+}
+
+TEST(unblock_policy, adaptive_below_ratio) {
+    AdaptivePolicy::Config cfg;
+    cfg.olderScanLimit = 32;
+    AdaptivePolicy p(cfg);
+    CHECK(p.decide(metrics(20, 2)).action == UnblockAction::ScanOlder);
+    CHECK(p.decide(metrics(20, 2)).scanDepth == 0);
+
+    // Long queues still get a pairwise scan, limited to the front.
+    UnblockDecision d = p.decide(metrics(400, 20));
+    CHECK(d.action == UnblockAction::ScanOlder);
+    CHECK(d.scanDepth == 32);
+}
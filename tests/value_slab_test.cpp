@@ -0,0 +1,84 @@
+#include "test_util.h"
+#include "core/value_slab.h"
+
+#include <string>
+
+TEST(value_slab, moves_between_inline_class_and_oversized) {
+    ValueSlab slab;
+    RecordValue v;
+    CHECK(v.isInline() && v.size() == 0);
+
+    std::string small(RecordValue::kInline, 's');
+    slab.assign(v, small);
+    CHECK(v.isInline());
+    CHECK(v.view() == small);
+    CHECK(slab.stats().blocks == 0);
+
+    // One byte over inline goes to the smallest size class.
+    std::string medium(RecordValue::kInline + 1, 'm');
+    slab.assign(v, medium);
+    CHECK(!v.isInline());
+    CHECK(v.capacity() == 32);
+    CHECK(v.view() == medium);
+    CHECK(slab.stats().blocks == 1 && slab.stats().usedBytes == 32);
+
+    std::string large(1000, 'l');
+    slab.assign(v, large);
+    CHECK(v.capacity() >= 1000 && v.capacity() <= 1250);
+    CHECK(v.view() == large);
+    CHECK(slab.stats().blocks == 1 && slab.stats().oversized == 0);
+
+    // Past the largest class (4 KiB) a value gets a block of its own.
+    std::string huge(5000, 'h');
+    slab.assign(v, huge);
+    CHECK(v.capacity() == 5000);
+    CHECK(v.view() == huge);
+    CHECK(slab.stats().oversized == 1);
+
+    slab.release(v);
+    CHECK(v.isInline() && v.size() == 0);
+    ValueSlabStats st = slab.stats();
+    CHECK(st.blocks == 0 && st.usedBytes == 0 && st.oversized == 0);
+}
+
+TEST(value_slab, overwrites_in_place_when_it_fits) {
+    ValueSlab slab;
+    RecordValue v;
+    slab.assign(v, std::string(200, 'a'));
+    const char* block = v.data();
+    std::size_t cap = v.capacity();
+
+    slab.assign(v, std::string(cap, 'b'));
+    CHECK(v.data() == block);
+    slab.assign(v, "short");
+    CHECK(v.data() == block && v.capacity() == cap);
+    CHECK(v.view() == "short");
+    CHECK(slab.stats().blocks == 1);
+
+    // The new bytes may be a view of the value itself.
+    slab.assign(v, std::string(150, 'x') + "tail");
+    slab.assign(v, v.view().substr(150));
+    CHECK(v.view() == "tail");
+    CHECK(v.data() == block);
+    slab.release(v);
+}
+
+TEST(value_slab, reuses_released_blocks) {
+    ValueSlab slab;
+    RecordValue a, b, c;
+    slab.assign(a, std::string(100, 'a'));
+    const char* block = a.data();
+    uint64_t reserved = slab.stats().reservedBytes;
+    slab.release(a);
+
+    slab.assign(b, std::string(100, 'b'));
+    CHECK(b.data() == block);
+    // Another value of the same class is carved from the same chunk.
+    slab.assign(c, std::string(100, 'c'));
+    CHECK(c.data() != block);
+    CHECK(slab.stats().reservedBytes == reserved);
+    CHECK(b.view() == std::string(100, 'b'));
+    CHECK(slab.stats().blocks == 2);
+    slab.release(b);
+    slab.release(c);
+}
@@ -0,0 +1,78 @@
+#ifndef TESTS_WORKLOAD_H
+#define TESTS_WORKLOAD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "core/vll_stman.h"
+#include "transaction/transaction.h"
+
+// A small deterministic workload shared by the tests that compare a store
+// rebuilt by replay or replication with the one that ran the transactions.
+namespace Testing {
+
+inline std::string key(int i) { return "k" + std::to_string(i); }
+
+inline void preload(::storageManager& store, int keys) {
+    for (int i = 0; i < keys; ++i) {
+        std::string k = key(i);
+        store.insert(k, "v" + std::to_string(i));
+    }
+    store.insert(std::string_view("counter"), "");
+}
+
+// Transaction i of the workload: reads up to two keys, writes one, bumps a
+// counter on every third. Overlapping sets make many of them conflict. Key sets are sorted and
+// reads exclude the written key, as the queue expects.
+inline ConcVLL::txn_ptr makeTxn(int i, int keys) {
+    std::string write = key(i % keys);
+    std::vector<std::string> reads;
+    for (int r : {i * 7 % keys, (i * 7 + 3) % keys}) {
+        if (key(r) != write) reads.push_back(key(r));
+    }
+    std::sort(reads.begin(), reads.end());
+    std::vector<ConcVLL::UpdateSpec> updates;
+    if (i % 3 == 0) updates.push_back(ConcVLL::UpdateSpec{"counter", UpdateOp::Add, i});
+    auto T = std::make_shared<ConcVLL::Transaction>(0);
+    T->assignKeys(reads, {write}, updates);
+    return T;
+}
+
+// Writes depend on the values read, so any divergence from the original
+// serial order shows up in the final checksum.
+inline void apply(::storageManager& store, const ConcVLL::Transaction& T) {
+    std::hash<std::string_view> hasher;
+    uint64_t h = T.id;
+    for (const auto& k : T.ReadSet) h = h * 31 + hasher(store.get(k)->value.view());
+    for (const auto& k : T.WriteSet) store.write(store.get(k), std::to_string(h), T.id);
+    for (const auto& u : T.UpdateSet) store.update(store.get(u.key), u.op, u.operand, T.id);
+}
+
+// Hands out transactions 0..count-1 of the workload, then null.
+class Feed {
+public:
+    Feed(int count, int keys) : count_(count), keys_(keys) {}
+
+    ConcVLL::txn_ptr next() {
+        std::lock_guard<std::mutex> lg(m_);
+        return next_ < count_ ? makeTxn(next_++, keys_) : nullptr;
+    }
+
+    bool exhausted() const {
+        std::lock_guard<std::mutex> lg(m_);
+        return next_ >= count_;
+    }
+
+private:
+    mutable std::mutex m_;
+    int next_ = 0;
+    int count_;
+    int keys_;
+};
+
+}
+
+#endif